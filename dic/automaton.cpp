@@ -21,16 +21,18 @@
 
 #include "config.h"
 
-#include <set>
-#include <list>
-#include <algorithm>
 #include <fstream>
-#include <sstream>
 #include <cstring>
+#include <cwctype>
 #include <boost/format.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "dic.h"
+#include "header.h"
+#include "dic_exception.h"
+#include "encoding.h"
 #include "regexp.h"
+#include "grammar.h"
 #include "automaton.h"
 #include "debug.h"
 
@@ -39,6 +41,7 @@ using boost::format;
 
 
 INIT_LOGGER(dic, Automaton);
+INIT_LOGGER(dic, AutomatonCache);
 
 
 #ifdef DEBUG_AUTOMATON
@@ -50,87 +53,80 @@ INIT_LOGGER(dic, Automaton);
 #define MAX_TRANSITION_LETTERS 256
 
 
-/* ************************************************** *
-   Definition of the automaton state
- * ************************************************** */
-
-static string idToString(const set<uint64_t> &iId);
+/**
+ * Set of states of the position automaton (see AutomatonHelper),
+ * as a bit field
+ */
+typedef vector<uint64_t> StateSet;
 
-class State
+static inline bool isInSet(const StateSet &iSet, unsigned int iState)
 {
-    DEFINE_LOGGER();
-public:
-    State(const set<uint64_t> iId) : m_id(iId) { init(); }
-    State(uint64_t iId)
-    {
-        m_id.insert(iId);
-        init();
-    }
-
-    const set<uint64_t> & getId() const { return m_id; }
-
-    // FIXME: should be private
-    bool m_accept;
-    int id_static;
-    State * m_next[MAX_TRANSITION_LETTERS];
-
-private:
-    /**
-     * Id of the state. For the first automaton, each ID contains only 1
-     * integer, but the ID of the deterministic automaton will contain
-     * several integers, according to the usual "determinization" algorithm.
-     */
-    set<uint64_t> m_id;
+    return (iSet[iState / 64] >> (iState % 64)) & 1;
+}
 
-    void init()
-    {
-        m_accept = false;
-        id_static = 0;
-        memset(m_next, 0, sizeof(State*) * MAX_TRANSITION_LETTERS);
-        DMSG("** state " << idToString(m_id) << " creation");
-    }
-};
+static inline void addToSet(StateSet &ioSet, unsigned int iState)
+{
+    ioSet[iState / 64] |= (uint64_t)1 << (iState % 64);
+}
 
-INIT_LOGGER(dic, State);
 
 /* ************************************************** *
-   Helper class, allowing to build a NFA, then a DFA
+   Helper class, allowing to build the automaton of the
+   positions of the regular expression, then the DFA
  * ************************************************** */
 
 class AutomatonHelper
 {
     DEFINE_LOGGER();
 public:
-    AutomatonHelper(State * iInitState);
-    ~AutomatonHelper();
+    /**
+     * Build the automaton of the positions, from "init_state", "ptl"
+     * and "PS" given by the parser. Its transitions are labelled with
+     * the symbols of the regular expression (letters, lists of letters,
+     * and epsilon).
+     */
+    AutomatonHelper(uint64_t iInitState, int *ptl, uint64_t *PS);
 
-    State * getInitState() const { return m_initState; }
-#ifdef DEBUG_AUTOMATON
-    void dump(const string &iFileName) const;
-#endif
+    /**
+     * Build the deterministic automaton on the letters (subset
+     * construction). The states are numbered from 1 (the init state),
+     * and the state 0 is the invalid state.
+     * @param iList: lists of letters matched by the list symbols
+     * @param oTransitions: transitions (see Automaton::m_transitions)
+     * @param oAcceptors: accepting flag of each state
+     */
+    void buildDfa(const searchRegExpLists &iList,
+                  vector<unsigned int> &oTransitions,
+                  vector<bool> &oAcceptors) const;
 
-    static AutomatonHelper *ps2nfa(uint64_t iInitState, int *ptl, uint64_t *PS);
-    static AutomatonHelper *nfa2dfa(const AutomatonHelper &iNfa,
-                                    const searchRegExpLists &iList);
+private:
+    /// Set of positions of each state (its ID)
+    vector<uint64_t> m_ids;
 
-    /// List of states
-    list<State *> m_states;
+    /// Accepting flag of each state
+    vector<bool> m_accept;
 
-private:
-    /// Initial state of the automaton
-    State * m_initState;
-
-    void addState(State * s);
-    State * getState(const set<uint64_t> &iId) const;
-    void printNodes(ostream &out) const;
-    void printEdges(ostream &out) const;
-    void setAccept(State * s) const;
-    set<uint64_t> getSuccessor(const set<uint64_t> &S, int letter,
-                               const searchRegExpLists &iList) const;
+    /**
+     * Transitions: the next state from state s with symbol l is at index
+     * s * MAX_TRANSITION_LETTERS + l (-1 if there is no such transition)
+     */
+    vector<int> m_next;
+
+    int getNext(unsigned int iState, int iSymbol) const
+    {
+        return m_next[iState * MAX_TRANSITION_LETTERS + iSymbol];
+    }
+
+    /**
+     * Add to ioSet the given state, and the states reachable from it
+     * with epsilon transitions
+     */
+    void addClosure(int iState, StateSet &ioSet) const;
 };
 
 INIT_LOGGER(dic, AutomatonHelper);
 
+
 /* ************************************************** *
    Definition of the Automaton class
  * ************************************************** */
@@ -138,79 +134,179 @@ INIT_LOGGER(dic, AutomatonHelper);
 Automaton::Automaton(uint64_t iInitState, int *ptl, uint64_t *PS,
                      const searchRegExpLists &iList)
 {
-    AutomatonHelper *nfa = AutomatonHelper::ps2nfa(iInitState, ptl, PS);
-    DMSG("Non deterministic automaton OK");
-#ifdef DEBUG_AUTOMATON
-    nfa->dump("auto_nfa");
-#endif
+    const AutomatonHelper positions(iInitState, ptl, PS);
+    DMSG("Position automaton OK");
 
-    AutomatonHelper *dfa = AutomatonHelper::nfa2dfa(*nfa, iList);
-    DMSG("Deterministic automaton OK");
+    positions.buildDfa(iList, m_transitions, m_acceptors);
+    m_nbStates = m_acceptors.size() - 1;
+    m_init = 1;
+    DMSG("Deterministic automaton OK (" << m_nbStates << " states)");
 #ifdef DEBUG_AUTOMATON
-    dfa->dump("auto_dfa");
+    dump("auto_dfa");
 #endif
 
-    finalize(*dfa);
-    DMSG("Final automaton OK");
+    minimize();
+    DMSG("Final automaton OK (" << m_nbStates << " states)");
 #ifdef DEBUG_AUTOMATON
     dump("auto_fin");
 #endif
-
-    delete nfa;
-    delete dfa;
 }
 
 
-Automaton::~Automaton()
+void Automaton::minimize()
 {
-    delete[] m_acceptors;
-    for (unsigned int i = 0; i <= m_nbStates; i++)
+    // The invalid state 0 is handled as a normal (sink) state
+    const unsigned int nbStates = m_nbStates + 1;
+
+    // Predecessors of each state, for each letter
+    vector<vector<unsigned int> > preds(nbStates * kNbLetters);
+    for (unsigned int s = 0; s < nbStates; ++s)
     {
-        delete[] m_transitions[i];
+        for (unsigned int l = 1; l < kNbLetters; ++l)
+        {
+            const unsigned int next = m_transitions[s * kNbLetters + l];
+            preds[next * kNbLetters + l].push_back(s);
+        }
     }
-    delete[] m_transitions;
-}
-
 
-void Automaton::finalize(const AutomatonHelper &iHelper)
-{
-    /* Creation */
-    m_nbStates = iHelper.m_states.size();
-    m_acceptors = new bool[m_nbStates + 1];
-    memset(m_acceptors, 0, (m_nbStates + 1) * sizeof(bool));
-    m_transitions = new int*[m_nbStates + 1];
-    for (unsigned int i = 0; i <= m_nbStates; i++)
+    // Initial partition: non-accepting and accepting states
+    vector<vector<unsigned int> > blocks(1);
+    vector<unsigned int> blockOf(nbStates, 0);
+    for (unsigned int s = 0; s < nbStates; ++s)
     {
-        m_transitions[i] = new int[MAX_TRANSITION_LETTERS];
-        memset(m_transitions[i], 0, MAX_TRANSITION_LETTERS * sizeof(int));
+        if (m_acceptors[s])
+        {
+            if (blocks.size() == 1)
+                blocks.push_back(vector<unsigned int>());
+            blockOf[s] = 1;
+        }
+        blocks[blockOf[s]].push_back(s);
     }
 
-    /* Create new id for states */
-    list<State *>::const_iterator it;
-    int i;
-    for (i = 1, it = iHelper.m_states.begin();
-         it != iHelper.m_states.end(); it++, i++)
+    // Blocks to use as splitters
+    vector<unsigned int> waiting;
+    vector<bool> isWaiting(blocks.size(), true);
+    for (unsigned int b = 0; b < blocks.size(); ++b)
+        waiting.push_back(b);
+
+    vector<bool> marked(nbStates, false);
+    vector<unsigned int> markedStates;
+    vector<unsigned int> nbMarked(nbStates, 0);
+    vector<unsigned int> touchedBlocks;
+    while (!waiting.empty())
     {
-        (*it)->id_static = i;
+        const unsigned int splitter = waiting.back();
+        waiting.pop_back();
+        isWaiting[splitter] = false;
+        const vector<unsigned int> splitterStates = blocks[splitter];
+
+        for (unsigned int l = 1; l < kNbLetters; ++l)
+        {
+            // Mark the states leading to the splitter with this letter
+            for (unsigned int i = 0; i < splitterStates.size(); ++i)
+            {
+                const vector<unsigned int> &p =
+                    preds[splitterStates[i] * kNbLetters + l];
+                for (unsigned int j = 0; j < p.size(); ++j)
+                {
+                    if (marked[p[j]])
+                        continue;
+                    marked[p[j]] = true;
+                    markedStates.push_back(p[j]);
+                    if (nbMarked[blockOf[p[j]]]++ == 0)
+                        touchedBlocks.push_back(blockOf[p[j]]);
+                }
+            }
+
+            // Split the blocks which are only partly marked
+            for (unsigned int i = 0; i < touchedBlocks.size(); ++i)
+            {
+                const unsigned int b = touchedBlocks[i];
+                if (nbMarked[b] < blocks[b].size())
+                {
+                    const unsigned int newBlock = blocks.size();
+                    blocks.push_back(vector<unsigned int>());
+                    vector<unsigned int> kept;
+                    for (unsigned int j = 0; j < blocks[b].size(); ++j)
+                    {
+                        const unsigned int s = blocks[b][j];
+                        if (marked[s])
+                        {
+                            blocks[newBlock].push_back(s);
+                            blockOf[s] = newBlock;
+                        }
+                        else
+                            kept.push_back(s);
+                    }
+                    blocks[b].swap(kept);
+
+                    isWaiting.push_back(false);
+                    if (isWaiting[b])
+                    {
+                        waiting.push_back(newBlock);
+                        isWaiting[newBlock] = true;
+                    }
+                    else
+                    {
+                        const unsigned int smaller =
+                            blocks[b].size() < blocks[newBlock].size() ? b : newBlock;
+                        waiting.push_back(smaller);
+                        isWaiting[smaller] = true;
+                    }
+                }
+                nbMarked[b] = 0;
+            }
+            touchedBlocks.clear();
+
+            for (unsigned int i = 0; i < markedStates.size(); ++i)
+                marked[markedStates[i]] = false;
+            markedStates.clear();
+        }
     }
 
-    /* Build new automaton */
-    for (it = iHelper.m_states.begin(); it != iHelper.m_states.end(); it++)
+    // Number the blocks in breadth-first order from the init state.
+    // The block of the invalid state (i.e. the states from which no word
+    // can be accepted) becomes the invalid state.
+    const unsigned int invalid = blocks.size();
+    vector<unsigned int> newId(blocks.size(), invalid);
+    newId[blockOf[0]] = 0;
+    vector<unsigned int> order;
+    if (newId[blockOf[m_init]] == invalid)
     {
-        State * s = *it;
-        int i = s->id_static;
-
-        if (s == iHelper.getInitState())
-            m_init = i;
-        if (s->m_accept)
-            m_acceptors[i] = true;
+        newId[blockOf[m_init]] = 1;
+        order.push_back(blockOf[m_init]);
+    }
+    for (unsigned int i = 0; i < order.size(); ++i)
+    {
+        const unsigned int s = blocks[order[i]][0];
+        for (unsigned int l = 1; l < kNbLetters; ++l)
+        {
+            const unsigned int b = blockOf[m_transitions[s * kNbLetters + l]];
+            if (newId[b] == invalid)
+            {
+                newId[b] = order.size() + 1;
+                order.push_back(b);
+            }
+        }
+    }
 
-        for (int l = 0; l < MAX_TRANSITION_LETTERS; l++)
+    vector<unsigned int> transitions((order.size() + 1) * kNbLetters, 0);
+    vector<bool> acceptors(order.size() + 1, false);
+    for (unsigned int i = 0; i < order.size(); ++i)
+    {
+        const unsigned int s = blocks[order[i]][0];
+        acceptors[i + 1] = m_acceptors[s];
+        for (unsigned int l = 1; l < kNbLetters; ++l)
         {
-            if (s->m_next[l])
-                m_transitions[i][l] = s->m_next[l]->id_static;
+            transitions[(i + 1) * kNbLetters + l] =
+                newId[blockOf[m_transitions[s * kNbLetters + l]]];
         }
     }
+
+    m_nbStates = order.size();
+    m_init = order.empty() ? 0 : 1;
+    m_transitions.swap(transitions);
+    m_acceptors.swap(acceptors);
 }
 
 
@@ -230,11 +326,11 @@ void Automaton::dump(const string &iFileName) const
     out << "\n";
     for (unsigned int i = 1; i <= m_nbStates; i++)
     {
-        for (int l = 0; l < MAX_TRANSITION_LETTERS; l++)
+        for (unsigned int l = 0; l < kNbLetters; l++)
         {
-            if (m_transitions[i][l])
+            if (getNextState(i, l))
             {
-                out << format("\t%1% -> %2%") % i % m_transitions[i][l];
+                out << format("\t%1% -> %2%") % i % getNextState(i, l);
                 out << format(" [label = \"%1%\"];\n") % regexpPrintLetter(l);
             }
         }
@@ -249,301 +345,313 @@ void Automaton::dump(const string &iFileName) const
    Definition of the AutomatonHelper class
  * ************************************************** */
 
-AutomatonHelper::AutomatonHelper(State * iInitState)
-    : m_initState(iInitState)
-{
-}
-
-
-AutomatonHelper::~AutomatonHelper()
-{
-    list<State *>::const_iterator it;
-    for (it = m_states.begin(); it != m_states.end(); it++)
-    {
-        delete *it;
-    }
-}
-
-
-void AutomatonHelper::addState(State * s)
-{
-    m_states.push_front(s);
-    DMSG("** state " << idToString(s->getId()) << " added to automaton");
-}
-
-
-State * AutomatonHelper::getState(const set<uint64_t> &iId) const
-{
-    list<State *>::const_iterator it;
-    for (it = m_states.begin(); it != m_states.end(); it++)
-    {
-        State * s = *it;
-        if (s->getId() == iId)
-        {
-            return s;
-        }
-    }
-    return NULL;
-}
-
-/* ************************************************** *
- * ************************************************** *
- * ************************************************** */
-
-AutomatonHelper *AutomatonHelper::ps2nfa(uint64_t init_state_id, int *ptl, uint64_t *PS)
+AutomatonHelper::AutomatonHelper(uint64_t init_state_id, int *ptl, uint64_t *PS)
 {
-    uint64_t maxpos = PS[0];
-    State * current_state;
+    const uint64_t maxpos = PS[0];
     bool used_letter[MAX_TRANSITION_LETTERS];
 
-
     /* 1: init_state = root->PP */
-    State * temp_state = new State(init_state_id);
-    AutomatonHelper *nfa = new AutomatonHelper(temp_state);
-    nfa->addState(temp_state);
-    list<State *> L;
-    L.push_front(temp_state);
+    boost::unordered_map<uint64_t, unsigned int> stateIds;
+    stateIds[init_state_id] = 0;
+    m_ids.push_back(init_state_id);
+    m_next.assign(MAX_TRANSITION_LETTERS, -1);
+
     /* 2: while \exist state \in state_list */
-    while (! L.empty())
+    for (unsigned int current = 0; current < m_ids.size(); ++current)
     {
-        current_state = L.front();
-        L.pop_front();
-        DMSG("** current state = " << idToString(current_state->getId()));
+        const uint64_t currentId = m_ids[current];
         memset(used_letter, 0, sizeof(used_letter));
         /* 3: \foreach l in \sigma | l \neq # */
         for (uint32_t p = 1; p < maxpos; p++)
         {
             int current_letter = ptl[p];
-            if (used_letter[current_letter] == false)
+            if (used_letter[current_letter])
+                continue;
+            used_letter[current_letter] = true;
+
+            /* 4: int set = \cup { PS(pos) | pos \in state \wedge pos == l } */
+            uint64_t ens = 0;
+            for (uint32_t pos = 1; pos <= maxpos; pos++)
             {
-                /* 4: int set = \cup { PS(pos) | pos \in state \wedge pos == l } */
-                uint64_t ens = 0;
-                for (uint32_t pos = 1; pos <= maxpos; pos++)
-                {
-                    if (ptl[pos] == current_letter &&
-                        (unsigned int)*(current_state->getId().begin()) & (1 << (pos - 1)))
-                        ens |= PS[pos];
-                }
-                /* 5: transition from current_state to temp_state */
-                if (ens)
+                if (ptl[pos] == current_letter &&
+                    (currentId & ((uint64_t)1 << (pos - 1))))
+                    ens |= PS[pos];
+            }
+            /* 5: transition from current_state to temp_state */
+            if (ens)
+            {
+                boost::unordered_map<uint64_t, unsigned int>::const_iterator it =
+                    stateIds.find(ens);
+                unsigned int next;
+                if (it != stateIds.end())
+                    next = it->second;
+                else
                 {
-                    set<uint64_t> temp_id;
-                    temp_id.insert(ens);
-                    temp_state = nfa->getState(temp_id);
-                    if (temp_state == NULL)
-                    {
-                        temp_state = new State(temp_id);
-                        nfa->addState(temp_state);
-                        L.push_front(temp_state);
-                    }
-                    current_state->m_next[current_letter] = temp_state;
+                    next = m_ids.size();
+                    stateIds[ens] = next;
+                    m_ids.push_back(ens);
+                    m_next.resize(m_next.size() + MAX_TRANSITION_LETTERS, -1);
                 }
-                used_letter[current_letter] = true;
+                m_next[current * MAX_TRANSITION_LETTERS + current_letter] = next;
             }
         }
     }
 
-    list<State *>::const_iterator it;
-    for (it = nfa->m_states.begin(); it != nfa->m_states.end(); it++)
-    {
-        State * s = *it;
-        if (*(s->getId().begin()) & (1 << (maxpos - 1)))
-            s->m_accept = true;
-    }
-
-    return nfa;
+    m_accept.resize(m_ids.size());
+    for (unsigned int s = 0; s < m_ids.size(); ++s)
+        m_accept[s] = (m_ids[s] >> (maxpos - 1)) & 1;
 }
 
-/* ************************************************** *
- * ************************************************** *
- * ************************************************** */
 
-set<uint64_t> AutomatonHelper::getSuccessor(const set<uint64_t> &S,
-                                            int letter,
-                                            const searchRegExpLists &iList) const
+void AutomatonHelper::addClosure(int iState, StateSet &ioSet) const
 {
-    set<uint64_t> R, r;
-    set<uint64_t>::const_iterator it;
-    for (it = S.begin(); it != S.end(); it++)                /* \forall y \in S */
+    // Each state has at most one epsilon transition. If a state is already
+    // in the set, the states following it are in the set too.
+    for (int s = iState; s >= 0 && !isInSet(ioSet, s);
+         s = getNext(s, RE_EPSILON))
     {
+        addToSet(ioSet, s);
+    }
+}
 
-        set<uint64_t> t;
-        t.insert(*it);
-        State *y = getState(t);
-        ASSERT(y != NULL, "Invalid state");
-
-        set<uint64_t> Ry;                                        /* Ry = \empty             */
-
-        State *z;
-        if ((z = y->m_next[letter]) != NULL)                   /* \delta (y,z) = l        */
-        {
-            r = getSuccessor(z->getId(), RE_EPSILON, iList);
-            Ry.insert(r.begin(), r.end());
-            Ry.insert(z->getId().begin(), z->getId().end()); /* Ry = Ry \cup succ(z)    */
-        }
 
-        /* \epsilon transition from start node */
-        if ((z = y->m_next[RE_EPSILON]) != NULL)               /* \delta (y,z) = \epsilon */
+void AutomatonHelper::buildDfa(const searchRegExpLists &iList,
+                               vector<unsigned int> &oTransitions,
+                               vector<bool> &oAcceptors) const
+{
+    const unsigned int nbStates = m_ids.size();
+    const unsigned int nbWords = (nbStates + 63) / 64;
+    const unsigned int kNbLetters = Automaton::kNbLetters;
+
+    // Successors of each state of the position automaton, for each letter:
+    // the states reached with the letter itself or with a list containing
+    // it, possibly after and before epsilon transitions
+    vector<StateSet> succ(nbStates * kNbLetters);
+    for (unsigned int y = 0; y < nbStates; ++y)
+    {
+        StateSet closure(nbWords, 0);
+        addClosure(y, closure);
+        for (int letter = 1; letter < DIC_LETTERS; letter++)
         {
-            r = getSuccessor(z->getId(), letter, iList);
-            Ry.insert(r.begin(), r.end());       /* Ry = Ry \cup succ(z)    */
+            StateSet &r = succ[y * kNbLetters + letter];
+            r.assign(nbWords, 0);
+            for (unsigned int w = 0; w < nbStates; ++w)
+            {
+                if (!isInSet(closure, w))
+                    continue;
+                if (getNext(w, letter) >= 0)
+                    addClosure(getNext(w, letter), r);
+                for (unsigned int i = 0; i < iList.symbl.size(); i++)
+                {
+                    if (iList.letters[i][letter] &&
+                        getNext(w, iList.symbl[i]) >= 0)
+                    {
+                        addClosure(getNext(w, iList.symbl[i]), r);
+                    }
+                }
+            }
         }
+    }
 
-        if (letter < RE_FINAL_TOK)
+    // Subset construction, with the sets of states as keys of a hash table.
+    // The state 0 is the invalid state, and the init state is the state 1.
+    boost::unordered_map<StateSet, unsigned int> dfaIds;
+    vector<StateSet> dfaStates(1);
+    StateSet init(nbWords, 0);
+    addToSet(init, 0);
+    dfaIds[init] = 1;
+    dfaStates.push_back(init);
+    oTransitions.assign(2 * kNbLetters, 0);
+
+    StateSet target(nbWords);
+    for (unsigned int current = 1; current < dfaStates.size(); ++current)
+    {
+        const StateSet currentSet = dfaStates[current];
+        for (int letter = 1; letter < DIC_LETTERS; letter++)
         {
-            for (unsigned int i = 0; i < iList.symbl.size(); i++)
+            target.assign(nbWords, 0);
+            bool empty = true;
+            for (unsigned int y = 0; y < nbStates; ++y)
             {
-                if (iList.letters[i][letter] && (z = y->m_next[(int)iList.symbl[i]]) != NULL)
+                if (!isInSet(currentSet, y))
+                    continue;
+                const StateSet &s = succ[y * kNbLetters + letter];
+                for (unsigned int i = 0; i < nbWords; ++i)
                 {
-                    DMSG("*** letter " << regexpPrintLetter(letter)
-                          << " is in " << regexpPrintLetter(i));
-
-                    r = getSuccessor(z->getId(), RE_EPSILON, iList);
-                    Ry.insert(r.begin(), r.end());
-                    Ry.insert(z->getId().begin(), z->getId().end());
+                    target[i] |= s[i];
+                    empty = empty && target[i] == 0;
                 }
             }
+            if (empty)
+                continue;
+
+            boost::unordered_map<StateSet, unsigned int>::const_iterator it =
+                dfaIds.find(target);
+            unsigned int next;
+            if (it != dfaIds.end())
+                next = it->second;
+            else
+            {
+                next = dfaStates.size();
+                dfaIds[target] = next;
+                dfaStates.push_back(target);
+                oTransitions.resize(oTransitions.size() + kNbLetters, 0);
+            }
+            oTransitions[current * kNbLetters + letter] = next;
         }
-
-        R.insert(Ry.begin(), Ry.end());                   /* R = R \cup Ry  */
     }
 
-    return R;
+    // A state is accepting if one of its positions states is
+    oAcceptors.assign(dfaStates.size(), false);
+    for (unsigned int d = 1; d < dfaStates.size(); ++d)
+    {
+        for (unsigned int y = 0; y < nbStates; ++y)
+        {
+            if (m_accept[y] && isInSet(dfaStates[d], y))
+            {
+                oAcceptors[d] = true;
+                break;
+            }
+        }
+    }
 }
 
 
-void AutomatonHelper::setAccept(State * s) const
+/* ************************************************** *
+   Definition of the AutomatonCache class
+ * ************************************************** */
+
+/**
+ * Initialize the lists of letters with pre-defined lists
+ * 0: all tiles
+ * 1: vowels
+ * 2: consonants
+ * 3: user defined 1
+ * 4: user defined 2
+ * x: lists used during parsing
+ */
+static void initLetterLists(const Dictionary &iDic,
+                            searchRegExpLists &iList)
 {
-    DMSG("=== setting accept for node (" << idToString(s->getId()) << ")");
-    list<State *>::const_iterator it;
-    for (it = m_states.begin(); it != m_states.end(); it++)
+    // Prepare the space for 5 items
+    iList.symbl.assign(5, 0);
+    iList.letters.assign(5, vector<bool>(DIC_LETTERS + 1, false));
+
+    iList.symbl[0] = RE_ALL_MATCH; // All letters
+    iList.symbl[1] = RE_VOWL_MATCH; // Vowels
+    iList.symbl[2] = RE_CONS_MATCH; // Consonants
+    iList.letters[0][0] = false;
+    iList.letters[1][0] = false;
+    iList.letters[2][0] = false;
+    const wstring &allLetters = iDic.getHeader().getLetters();
+    for (size_t i = 1; i <= allLetters.size(); ++i)
     {
-        const State * ns = *it;
-        uint64_t idx = *(ns->getId().begin());
-        if (ns->m_accept && (std::find(s->getId().begin(), s->getId().end(), idx) != s->getId().end()))
-        {
-            DMSG("    --> " << idToString(ns->getId()));
-            s->m_accept = true;
-            break;
-        }
+        iList.letters[0][i] = true;
+        iList.letters[1][i] = iDic.getHeader().isVowel(i);
+        iList.letters[2][i] = iDic.getHeader().isConsonant(i);
     }
+
+    iList.symbl[3] = RE_USR1_MATCH; // User defined list 1
+    iList.symbl[4] = RE_USR2_MATCH; // User defined list 2
 }
 
 
-AutomatonHelper *AutomatonHelper::nfa2dfa(const AutomatonHelper &iNfa,
-                                          const searchRegExpLists &iList)
+AutomatonCache::AutomatonCache(const Dictionary &iDic, unsigned int iMaxSize)
+    : m_dic(iDic), m_maxSize(iMaxSize)
 {
-    list<State *> L;
-
-    // Clone the list
-    State * temp_state = new State(iNfa.m_initState->getId());
-    AutomatonHelper *dfa = new AutomatonHelper(temp_state);
-    dfa->addState(temp_state);
-    L.push_front(temp_state);
-    while (! L.empty())
-    {
-        State * current_state = L.front();
-        L.pop_front();
-        DMSG("** current state = " << idToString(current_state->getId()));
-        for (int letter = 1; letter < DIC_LETTERS; letter++)
-        {
-            set<uint64_t> temp_id = iNfa.getSuccessor(current_state->getId(), letter, iList);
+    initLetterLists(iDic, m_predefinedLists);
+}
 
-            if (! temp_id.empty())
-            {
-                DMSG("*** successor of " << idToString(current_state->getId())
-                      << " for " << regexpPrintLetter(letter) << " = " << idToString(temp_id));
 
-                temp_state = dfa->getState(temp_id);
+boost::shared_ptr<const Automaton>
+AutomatonCache::getAutomaton(const wstring &iRegexp)
+{
+    const wstring key = normalize(iRegexp);
 
-                if (temp_state == NULL)
-                {
-                    temp_state = new State(temp_id);
-                    dfa->addState(temp_state);
-                    L.push_front(temp_state);
-                }
-                current_state->m_next[letter] = temp_state;
-            }
-        }
-    }
+#if HAVE_BOOST_THREAD
+    boost::mutex::scoped_lock lock(m_mutex);
+#endif
 
-    list<State *>::const_iterator it;
-    for (it = dfa->m_states.begin(); it != dfa->m_states.end(); it++)
+    boost::unordered_map<wstring, list<Entry>::iterator>::const_iterator it =
+        m_positions.find(key);
+    if (it != m_positions.end())
     {
-        iNfa.setAccept(*it);
+        // Move the automaton to the front of the list
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return m_entries.front().second;
     }
 
-    return dfa;
-}
-
-/* ************************************************** *
- * ************************************************** *
- * ************************************************** */
+    boost::shared_ptr<const Automaton> automaton(buildAutomaton(iRegexp));
+    if (m_maxSize == 0)
+        return automaton;
 
-static string idToString(const set<uint64_t> &iId)
-{
-    ostringstream oss;
-    set<uint64_t>::const_iterator it;
-    for (it = iId.begin(); it != iId.end(); it++)
+    // Discard the least recently used automaton if needed
+    if (m_entries.size() >= m_maxSize)
     {
-        oss << *it << ' ';
+        m_positions.erase(m_entries.back().first);
+        m_entries.pop_back();
     }
-    return oss.str();
+    m_entries.push_front(Entry(key, automaton));
+    m_positions[key] = m_entries.begin();
+    return automaton;
 }
 
 
-void AutomatonHelper::printNodes(ostream &out) const
+wstring AutomatonCache::normalize(const wstring &iRegexp) const
 {
-    list<State *>::const_iterator it;
-    for (it = m_states.begin(); it != m_states.end(); it++)
+    // The letters are accepted in lower case too, but the ":v:", ":c:",
+    // ":1:" and ":2:" tokens must be kept as is
+    const wstring &letters = m_dic.getHeader().getLetters();
+    wstring result = iRegexp;
+    for (unsigned int i = 0; i < result.size(); ++i)
     {
-        State * s = *it;
-        const string &sid = idToString(s->getId());
-        out << format("\t\"%1%\" [label = \"%2%\"") % sid % sid;
-        if (s == m_initState)
+        if (result[i] == L':' && i + 2 < result.size() && result[i + 2] == L':')
         {
-            out << ", style = filled, color=lightgrey";
+            i += 2;
+            continue;
         }
-        if (s->m_accept)
+        const wchar_t upChar = towupper(result[i]);
+        if (upChar != result[i] && (wchar_t)towlower(upChar) == result[i] &&
+            letters.find(upChar) != wstring::npos)
         {
-            out << ", shape = doublecircle";
+            result[i] = upChar;
         }
-        out << "];\n";
     }
-    out << "\n";
+    return result;
 }
 
 
-void AutomatonHelper::printEdges(ostream &out) const
+Automaton * AutomatonCache::buildAutomaton(const wstring &iRegexp) const
 {
-    list<State *>::const_iterator it;
-    for (it = m_states.begin(); it != m_states.end(); it++)
+    // Parsing
+    Node *root = NULL;
+    searchRegExpLists llist = m_predefinedLists;
+    bool parsingOk = parseRegexp(m_dic, (iRegexp + L"#").c_str(), &root, llist);
+
+    if (!parsingOk)
     {
-        State * s = *it;
-        for (int letter = 0; letter < 255; letter++)
-        {
-            if (s->m_next[letter])
-            {
-                out << format("\t\"%1%\" -> ") % idToString(s->getId());
-                out << format("\"%1%\" [label = \"") % idToString(s->m_next[letter]->getId());
-                out << regexpPrintLetter(letter);
-                out << "\"];\n";
-            }
-        }
+        delete root;
+        throw InvalidRegexpException(lfw(iRegexp));
     }
-}
 
+    int ptl[REGEXP_MAX+1];
+    uint64_t PS[REGEXP_MAX+1];
 
-#ifdef DEBUG_AUTOMATON
-void AutomatonHelper::dump(const string &iFileName) const
-{
-    ofstream out(iFileName.c_str());
-    out << "digraph automaton {\n";
-    printNodes(out);
-    printEdges(out);
-    out << "fontsize=20;\n";
-    out << "}\n";
-    out.close();
-}
-#endif
+    for (int i = 0; i < REGEXP_MAX; i++)
+    {
+        PS[i] = 0;
+        ptl[i] = 0;
+    }
+
+    int n = 1;
+    int p = 1;
+    root->traverse(p, n, ptl);
+    PS [0] = p - 1;
+    ptl[0] = p - 1;
 
+    root->nextPos(PS);
+
+    Automaton *a = new Automaton(root->getFirstPos(), ptl, PS, llist);
+    delete root;
+    return a;
+}
@@ -22,11 +22,34 @@
 #ifndef DIC_AUTOMATON_H_
 #define DIC_AUTOMATON_H_
 
+#include <vector>
+#include <string>
+#include <list>
+#include <utility>
+#include <stdint.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#if HAVE_BOOST_THREAD
+#   include <boost/thread/mutex.hpp>
+#endif
+
+#include "regexp.h"
 #include "logging.h"
 
-class AutomatonHelper;
-struct searchRegExpLists;
+using std::vector;
+using std::string;
+using std::wstring;
+using std::list;
+using std::pair;
 
+class Dictionary;
+
+/**
+ * Minimal deterministic finite automaton recognizing the words matched
+ * by a regular expression.
+ * The states are numbered from 1 to getNbStates(), and 0 is the invalid
+ * state (reached after any letter which cannot lead to a match).
+ */
 class Automaton
 {
     DEFINE_LOGGER();
@@ -39,9 +62,6 @@ public:
     Automaton(uint64_t init_state, int *ptl, uint64_t *PS,
               const searchRegExpLists &iList);
 
-    /// Destructor
-    ~Automaton();
-
     /**
      * Get the number of states in the automaton.
      * @returns number of states
@@ -58,15 +78,15 @@ public:
      * Query the acceptor flag for the given state
      * @return true/false
      */
-    bool accept(uint64_t state) const { return m_acceptors[state]; }
+    bool accept(unsigned int state) const { return m_acceptors[state]; }
 
     /**
      * Return the next state when the transition is taken
      * @returns next state id (1 <= id <= nstate, 0 = invalid id)
      */
-    uint64_t getNextState(uint64_t start, char l) const
+    unsigned int getNextState(unsigned int start, char l) const
     {
-        return m_transitions[start][(int)l];
+        return m_transitions[start * kNbLetters + l];
     }
 
     /**
@@ -74,20 +94,93 @@ public:
      */
     void dump(const string &iFileName) const;
 
+    /// Number of letter codes (they are stored on 6 bits in the dictionary)
+    static const unsigned int kNbLetters = 64;
+
 private:
     /// Number of states
     unsigned int m_nbStates;
 
     /// ID of the init state
-    uint64_t m_init;
+    unsigned int m_init;
 
-    /// Array of booleans, one for each state
-    bool *m_acceptors;
+    /// Accepting flag of each state (including the invalid state 0)
+    vector<bool> m_acceptors;
 
-    /// Matrix of transitions
-    int **m_transitions;
+    /**
+     * Transitions of all the states, in a single table: the next state
+     * from state s with letter l is at index s * kNbLetters + l
+     */
+    vector<unsigned int> m_transitions;
+
+    /**
+     * Merge the equivalent states (Hopcroft's algorithm), and renumber
+     * the remaining states in breadth-first order from the init state
+     */
+    void minimize();
+};
 
-    void finalize(const AutomatonHelper &a);
+
+/**
+ * Cache of the automata built for the last regular expressions searched in
+ * a dictionary (see Dictionary::searchRegExp()). When the cache is full, the
+ * least recently used automaton is discarded.
+ * The automata are shared, so that they remain usable after being discarded.
+ * The cache can be used from several threads at the same time.
+ */
+class AutomatonCache
+{
+    DEFINE_LOGGER();
+public:
+    /**
+     * Constructor
+     * @param iDic: dictionary whose letters are used in the expressions
+     * @param iMaxSize: maximum number of automata kept in the cache
+     */
+    AutomatonCache(const Dictionary &iDic, unsigned int iMaxSize);
+
+    /**
+     * Return the automaton recognizing the given regular expression,
+     * building it (and adding it to the cache) if needed
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    boost::shared_ptr<const Automaton> getAutomaton(const wstring &iRegexp);
+
+private:
+    const Dictionary &m_dic;
+    unsigned int m_maxSize;
+
+    /**
+     * Lists of letters predefined for all the regular expressions (they
+     * only depend on the dictionary). The lists of the expressions are
+     * initialized with a copy of these ones.
+     */
+    searchRegExpLists m_predefinedLists;
+
+    typedef pair<wstring, boost::shared_ptr<const Automaton> > Entry;
+
+    /// Cached automata, from the most recently used to the least recently used
+    list<Entry> m_entries;
+
+    /// Position of the automata in m_entries, for each normalized expression
+    boost::unordered_map<wstring, list<Entry>::iterator> m_positions;
+
+#if HAVE_BOOST_THREAD
+    /// Protect the cache against concurrent accesses
+    boost::mutex m_mutex;
+#endif
+
+    /**
+     * Return the key of the given expression in the cache, i.e. the
+     * expression with its letters converted to upper case
+     */
+    wstring normalize(const wstring &iRegexp) const;
+
+    /**
+     * Parse the given expression and build its automaton
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    Automaton * buildAutomaton(const wstring &iRegexp) const;
 };
 
 #endif /* _DIC_AUTOMATON_H_ */
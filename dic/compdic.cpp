@@ -24,9 +24,12 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/foreach.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <ctime>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -37,7 +40,13 @@
 #include <cerrno>
 #include <cstring>
 
+#if HAVE_BOOST_THREAD
+#   include <boost/thread/thread.hpp>
+#endif
+
 #include "compdic.h"
+#include "dic.h"
+#include "word_list_reader.h"
 #include "encoding.h"
 #include "dic_exception.h"
 
@@ -60,33 +69,43 @@
 #   define _(String) String
 #endif
 
-#define MAX_STRING_LENGTH 200
+// Character used in the word list of the GADDAG to represent the separator.
+// It sorts before any letter, and it is converted to DIC_GADDAG_SEPARATOR
+// when the edges are created.
+static const wchar_t kSeparatorChar = L'\x01';
 
 // Useful shortcut
 #define fmt(a) boost::format(a)
 
+using boost::posix_time::ptime;
+using boost::posix_time::time_duration;
+using boost::posix_time::microsec_clock;
+
 
 INIT_LOGGER(dic, CompDic);
 
 
 CompDic::CompDic()
-    : m_currentRec(0), m_maxRec(0), m_loadTime(0), m_buildTime(0)
+    : m_streaming(false), m_anagrams(false), m_wordCounts(false), m_childMasks(false), m_nbThreads(1), m_nodeSet(1 << 16, NodeHash(&m_edges), NodeEqual(&m_edges)),
+      m_loadTime(0), m_buildTime(0)
 {
     m_headerInfo.root       = 0;
+    m_headerInfo.gaddagRoot = 0;
+    m_headerInfo.anagramSize = 0;
+    m_headerInfo.wordCountsSize = 0;
+    m_headerInfo.childMasksSize = 0;
     m_headerInfo.nwords     = 0;
     m_headerInfo.nodesused  = 1;
     m_headerInfo.edgesused  = 1;
     m_headerInfo.nodessaved = 0;
     m_headerInfo.edgessaved = 0;
-
-    m_stringBuf = new wchar_t[MAX_STRING_LENGTH];
-    m_endString = m_stringBuf;
+    m_headerInfo.dawg       = true;
+    m_headerInfo.nativeEdges = false;
 }
 
 
 CompDic::~CompDic()
 {
-    delete[] m_stringBuf;
 }
 
 
@@ -140,45 +159,149 @@ void CompDic::addLetter(wchar_t chr, int points, int frequency,
 
 void CompDic::loadWordList(const string &iFileName, vector<wstring> &oWordList)
 {
-    ifstream file(iFileName.c_str(), ios::in | ios::binary);
-    if (!file.is_open())
-        throw DicException((fmt(_("Could not open file '%1%'")) % iFileName).str());
-
-    // Get the file size
-    struct stat stat_buf;
-    if (stat(iFileName.c_str(), &stat_buf) < 0)
-        throw DicException((fmt(_("Could not open file '%1%'")) % iFileName).str());
-    int dicSize = (unsigned int)stat_buf.st_size;
+    WordListReader reader(iFileName, m_headerInfo.letters);
 
     // Reserve some space (heuristic: the average length of words is 11)
-    oWordList.reserve(dicSize / 11);
+    oWordList.reserve(reader.getSize() / 11);
 
-    string line;
-    while (getline(file, line))
+    unsigned int lineNb;
+    wstring word;
+    while (reader.readWord(word, lineNb))
     {
-        // If there is a BOM in the file, remove it from the first word
-        if (oWordList.empty() && line.size() >= 3 &&
-            (uint8_t)line[0] == 0xEF &&
-            (uint8_t)line[1] == 0xBB &&
-            (uint8_t)line[2] == 0xBF)
+        oWordList.push_back(word);
+    }
+
+    // Sort the word list, to perform a better compression
+    sort(oWordList.begin(), oWordList.end());
+    // Remove the duplicates (addWord() would reject them)
+    oWordList.erase(unique(oWordList.begin(), oWordList.end()),
+                    oWordList.end());
+}
+
+
+void CompDic::buildGaddagList(const vector<wstring> &iWordList,
+                              vector<wstring> &oGaddagList) const
+{
+    // Each word of length n gives n entries: for each i in [1, n], the
+    // reversed prefix of length i, the separator, and the rest of the word.
+    // For example, "CAT" gives "C^AT", "AC^T" and "TAC^" (where ^ is the
+    // separator).
+    size_t nbEntries = 0;
+    BOOST_FOREACH(const wstring &word, iWordList)
+    {
+        nbEntries += word.size();
+    }
+    oGaddagList.reserve(nbEntries);
+
+    BOOST_FOREACH(const wstring &word, iWordList)
+    {
+        for (unsigned int i = 1; i <= word.size(); ++i)
         {
-            line = line.substr(3);
+            wstring entry(word.rend() - i, word.rend());
+            entry += kSeparatorChar;
+            entry.append(word, i, wstring::npos);
+            oGaddagList.push_back(entry);
         }
-        // Remove potential \r
-        if (line[line.size() - 1] == '\r')
-            line = line.substr(0, line.size() - 1);
-        // Ignore empty lines
-        if (line == "")
-            continue;
-        // Ensure the word is in upper case
-        wstring wstr = readFromUTF8(line, "loadWordList");
-        std::transform(wstr.begin(), wstr.end(), wstr.begin(), towupper);
+    }
+
+    sort(oGaddagList.begin(), oGaddagList.end());
+    // Remove the duplicates, if any (makeNode() cannot handle them)
+    oGaddagList.erase(unique(oGaddagList.begin(), oGaddagList.end()),
+                      oGaddagList.end());
+}
+
 
-        oWordList.push_back(wstr);
+void CompDic::buildAnagramIndex(const vector<wstring> &iWordList,
+                                const Header &iHeader,
+                                vector<uint8_t> &oIndex) const
+{
+    // Pairs (sorted codes, codes of the word), sorted by code, so that the
+    // anagrams are grouped and listed in the order of the dictionary
+    vector<pair<string, string> > entries;
+    entries.reserve(iWordList.size());
+    BOOST_FOREACH(const wstring &word, iWordList)
+    {
+        string codes(word.size(), '\0');
+        for (unsigned int i = 0; i < word.size(); ++i)
+        {
+            codes[i] = iHeader.getCodeFromChar(word[i]);
+        }
+        string alphagram = codes;
+        std::sort(alphagram.begin(), alphagram.end());
+        entries.push_back(make_pair(alphagram, codes));
     }
+    std::sort(entries.begin(), entries.end());
 
-    // Sort the word list, to perform a better compression
-    sort(oWordList.begin(), oWordList.end());
+    // Position of the first entry of each group, and of the end
+    vector<uint32_t> groupStarts;
+    for (unsigned int i = 0; i < entries.size(); ++i)
+    {
+        if (i == 0 || entries[i].first != entries[i - 1].first)
+            groupStarts.push_back(i);
+    }
+    const uint32_t nbGroups = groupStarts.size();
+    groupStarts.push_back(entries.size());
+
+    // Power of 2 number of buckets, with at most one group per bucket
+    // on average
+    uint32_t nbBuckets = 1;
+    while (nbBuckets < nbGroups)
+        nbBuckets *= 2;
+
+    // Order the groups by bucket
+    vector<pair<uint32_t, uint32_t> > groupBuckets(nbGroups);
+    for (uint32_t g = 0; g < nbGroups; ++g)
+    {
+        const string &alphagram = entries[groupStarts[g]].first;
+        const uint32_t hash =
+            hashCodes((const uint8_t*)alphagram.data(), alphagram.size());
+        groupBuckets[g] = make_pair(hash & (nbBuckets - 1), g);
+    }
+    std::sort(groupBuckets.begin(), groupBuckets.end());
+
+    // Each group contains its sorted codes followed by its words,
+    // all of them terminated by a 0
+    vector<uint32_t> bucketStarts(nbBuckets + 1, 0);
+    vector<uint32_t> groupOffsets;
+    groupOffsets.reserve(nbGroups + 1);
+    string data;
+    for (uint32_t i = 0; i < nbGroups; ++i)
+    {
+        bucketStarts[groupBuckets[i].first + 1]++;
+        const uint32_t g = groupBuckets[i].second;
+        groupOffsets.push_back(data.size());
+        data += entries[groupStarts[g]].first;
+        data += '\0';
+        for (uint32_t e = groupStarts[g]; e < groupStarts[g + 1]; ++e)
+        {
+            data += entries[e].second;
+            data += '\0';
+        }
+    }
+    groupOffsets.push_back(data.size());
+    for (uint32_t b = 0; b < nbBuckets; ++b)
+        bucketStarts[b + 1] += bucketStarts[b];
+
+    // Serialize the index, with the integers in the byte order of the edges
+    vector<uint32_t> integers;
+    integers.reserve(nbBuckets + nbGroups + 3);
+    integers.push_back(nbBuckets);
+    integers.insert(integers.end(), bucketStarts.begin(), bucketStarts.end());
+    integers.insert(integers.end(), groupOffsets.begin(), groupOffsets.end());
+    if (!m_headerInfo.nativeEdges)
+    {
+        for (unsigned int i = 0; i < integers.size(); ++i)
+        {
+            integers[i] = htonl(integers[i]);
+        }
+    }
+    // Pad the data to keep a multiple of 4 bytes
+    data.resize((data.size() + 3) & ~3, '\0');
+
+    oIndex.resize(integers.size() * sizeof(uint32_t) + data.size());
+    memcpy(&oIndex.front(), &integers.front(), integers.size() * sizeof(uint32_t));
+    memcpy(&oIndex.front() + integers.size() * sizeof(uint32_t),
+           data.data(), data.size());
 }
 
 
@@ -192,147 +315,431 @@ Header CompDic::writeHeader(ostream &outFile) const
 }
 
 
-void CompDic::writeNode(DicEdge *ioEdges, unsigned int num, ostream &outFile)
+void CompDic::buildWordCounts(vector<uint32_t> &oCounts) const
 {
-    uint32_t *edgesAsUint = reinterpret_cast<uint32_t*>(ioEdges);
-    // Handle endianness
-    for (unsigned int i = 0; i < num; ++i)
+    // Only the edges of the DAWG are counted: they precede its root edge,
+    // and the GADDAG (if any) follows it
+    const uint32_t root = m_headerInfo.root;
+
+    // Number of words of each node, at the position of its first edge
+    // (the special node 0 has no word)
+    vector<uint32_t> nodeCounts(root + 1, 0);
+    oCounts.assign(root + 1, 0);
+    uint32_t nodeStart = 1;
+    uint32_t count = 0;
+    for (uint32_t i = 1; i <= root; ++i)
     {
-        edgesAsUint[i] = htonl(edgesAsUint[i]);
+        const DicEdge &edge = m_edges[i];
+        // The children are always registered before their parent
+        if (edge.ptr >= nodeStart)
+            throw DicException("CompDic::buildWordCounts: unexpected order of the nodes");
+        count += edge.term + nodeCounts[edge.ptr];
+        oCounts[i] = count;
+        // The root edge is not part of a node
+        if (edge.last || i == root)
+        {
+            nodeCounts[nodeStart] = count;
+            nodeStart = i + 1;
+            count = 0;
+        }
     }
 
-    LOG_TRACE(fmt("writing %1% edges") % num);
-    outFile.write((char*)edgesAsUint, num * sizeof(DicEdge));
+    // The counts are stored in the byte order of the edges
+    if (!m_headerInfo.nativeEdges)
+    {
+        for (unsigned int i = 0; i < oCounts.size(); ++i)
+        {
+            oCounts[i] = htonl(oCounts[i]);
+        }
+    }
 }
 
-#define MAX_EDGES 2000
-/* ods3: ??   */
-/* ods4: 1746 */
-
-// Hashing function for a vector of DicEdge, based on the hashing function
-// of the HashTable
-size_t hash_value(const DicEdge &iEdge)
-{
-    const uint32_t *num = reinterpret_cast<const uint32_t*>(&iEdge);
-    size_t seed = 0;
-    boost::hash_combine(seed, *num);
-    return seed;
-}
 
-#ifdef CHECK_RECURSION
-class IncDec
+void CompDic::buildChildMasks(vector<uint32_t> &oMasks) const
 {
-    public:
-        IncDec(int &ioCounter) : m_counter(ioCounter) { ++m_counter; }
-        ~IncDec() { --m_counter; }
-    private:
-        int &m_counter;
-};
-#endif
-
+    // Flag the first edge of each node with several edges (the nodes
+    // with a single edge are scanned as fast as they would be indexed)
+    const uint32_t nbEdges = m_edges.size();
+    const uint32_t nbBlocks = (nbEdges + 31) / 32;
+    vector<uint32_t> starts(nbBlocks, 0);
+    for (uint32_t i = 1; i < nbEdges; ++i)
+    {
+        const uint32_t node = m_edges[i].ptr;
+        if (node != 0 && !m_edges[node].last)
+            starts[node / 32] |= (uint32_t)1 << (node % 32);
+    }
 
-unsigned int CompDic::makeNode(ostream &outFile, const Header &iHeader,
-                               vector<wstring>::const_iterator &itCurrWord,
-                               const vector<wstring>::const_iterator &itLastWord,
-                               wstring::const_iterator &itPosInWord,
-                               const wchar_t *iPrefix)
-{
-#ifdef CHECK_RECURSION
-    IncDec inc(m_currentRec);
-    if (m_currentRec > m_maxRec)
-        m_maxRec = m_currentRec;
-
-    // Instead of creating a vector, try to reuse an existing one
-    vector<DicEdge> &edges = m_mapForDepth[m_currentRec];
-    edges.reserve(MAX_EDGES);
-    edges.clear();
-#else
-    vector<DicEdge> edges;
-    // Optimize allocation
-    edges.reserve(MAX_EDGES);
-#endif
-    DicEdge newEdge;
+    // Rank of the first node of each block, and flags of the block
+    oMasks.clear();
+    uint32_t nbNodes = 0;
+    for (uint32_t b = 0; b < nbBlocks; ++b)
+    {
+        oMasks.push_back(nbNodes);
+        oMasks.push_back(starts[b]);
+        for (uint32_t bits = starts[b]; bits; bits &= bits - 1)
+            ++nbNodes;
+    }
 
-    while (iPrefix == m_endString)
+    // Mask of the codes of the children of each flagged node, in the
+    // order of the nodes
+    for (uint32_t node = 1; node < nbEdges; ++node)
     {
-        // More edges out of node
-        newEdge.ptr  = 0;
-        newEdge.term = 0;
-        newEdge.last = 0;
-        try
+        if ((starts[node / 32] & ((uint32_t)1 << (node % 32))) == 0)
+            continue;
+        uint64_t mask = 0;
+        uint32_t i = node;
+        do
         {
-            newEdge.chr = iHeader.getCodeFromChar(*m_endString = *itPosInWord);
-            ++m_endString;
-            ++itPosInWord;
-        }
-        catch (DicException &e)
+            // The position of a child is deduced from the mask
+            // (see Dictionary::getSuccByCode())
+            if (((uint64_t)1 << m_edges[i].chr) <= mask)
+                throw DicException("CompDic::buildChildMasks: unsorted node");
+            mask |= (uint64_t)1 << m_edges[i].chr;
+        } while (!m_edges[i++].last);
+        oMasks.push_back((uint32_t)mask);
+        oMasks.push_back((uint32_t)(mask >> 32));
+    }
+
+    // The masks are stored in the byte order of the edges
+    if (!m_headerInfo.nativeEdges)
+    {
+        for (unsigned int i = 0; i < oMasks.size(); ++i)
         {
-            // If an invalid character is found, be specific about the problem
-            ostringstream oss;
-            oss << fmt(_("Error in the word list on line %1%, col %2%: %3%"))
-                % (1 + m_headerInfo.nwords)
-                % (1 + m_endString - m_stringBuf)
-                % e.what() << endl;
-            throw DicException(oss.str());
+            oMasks[i] = htonl(oMasks[i]);
         }
-        edges.push_back(newEdge);
+    }
+}
+
 
-        // End of a word?
-        if (itPosInWord == itCurrWord->end())
+void CompDic::writeEdges(ostream &outFile) const
+{
+    // Handle endianness, by blocks to limit the memory used
+    const unsigned int kBlockSize = 65536;
+    vector<uint32_t> edgesAsUint(kBlockSize);
+    for (unsigned int start = 0; start < m_edges.size(); start += kBlockSize)
+    {
+        const unsigned int num = std::min(kBlockSize, (unsigned int)m_edges.size() - start);
+        memcpy(&edgesAsUint.front(), &m_edges[start], num * sizeof(DicEdge));
+        if (!m_headerInfo.nativeEdges)
         {
-            m_headerInfo.nwords++;
-            *m_endString = L'\0';
-            // Mark edge as word
-            edges.back().term = 1;
-
-            // Next word
-            ++itCurrWord;
-            // At the end of input?
-            if (itCurrWord == itLastWord)
-                break;
-            itPosInWord = itCurrWord->begin();
-
-            m_endString = m_stringBuf;
-            // This assumes that a word cannot be a prefix of the previous one
-            while (*m_endString == *itPosInWord)
+            for (unsigned int i = 0; i < num; ++i)
             {
-                ++m_endString;
-                ++itPosInWord;
+                edgesAsUint[i] = htonl(edgesAsUint[i]);
             }
         }
-        // Make dawg pointed to by this edge
-        edges.back().ptr = makeNode(outFile, iHeader, itCurrWord, itLastWord,
-                                    itPosInWord, iPrefix + 1);
+
+        LOG_TRACE(fmt("writing %1% edges") % num);
+        outFile.write((char*)&edgesAsUint.front(), num * sizeof(DicEdge));
     }
+    if (!outFile.good())
+        throw DicException(_("Error when writing the edges"));
+}
+
+
+size_t CompDic::NodeHash::operator()(uint32_t iNode) const
+{
+    size_t seed = 0;
+    const DicEdge *edgePtr = &(*m_edges)[iNode];
+    do
+    {
+        boost::hash_combine(seed, *reinterpret_cast<const uint32_t*>(edgePtr));
+    } while (!(*edgePtr++).last);
+    return seed;
+}
+
 
-    int numedges = edges.size();
+bool CompDic::NodeEqual::operator()(uint32_t iNode1, uint32_t iNode2) const
+{
+    const DicEdge *edgePtr1 = &(*m_edges)[iNode1];
+    const DicEdge *edgePtr2 = &(*m_edges)[iNode2];
+    for (;; ++edgePtr1, ++edgePtr2)
+    {
+        // The "last" flags are compared too
+        if (!(*edgePtr1 == *edgePtr2))
+            return false;
+        if (edgePtr1->last)
+            return true;
+    }
+}
+
+
+static bool edgeCodeLess(const DicEdge &iEdge1, const DicEdge &iEdge2)
+{
+    return iEdge1.chr < iEdge2.chr;
+}
+
+
+unsigned int CompDic::registerNode(vector<DicEdge> &ioEdges)
+{
+    const unsigned int numedges = ioEdges.size();
     if (numedges == 0)
     {
         // Special node zero - no edges
         return 0;
     }
 
-    // Mark the last edge
-    edges.back().last = 1;
+    // Sort the edges by code (the word list is sorted by character, which
+    // can be a different order), so that the Dictionary class can index
+    // the children of a node by their code
+    sort(ioEdges.begin(), ioEdges.end(), edgeCodeLess);
 
-    HashMap::const_iterator itMap = m_hashMap.find(edges);
-    if (itMap != m_hashMap.end())
+    // Mark the last edge
+    for (unsigned int i = 0; i < numedges; ++i)
+        ioEdges[i].last = 0;
+    ioEdges.back().last = 1;
+
+    // Append the node temporarily to m_edges, to be able to look for it
+    const unsigned int nodePos = m_edges.size();
+    m_edges.insert(m_edges.end(), ioEdges.begin(), ioEdges.end());
+    NodeSet::const_iterator it = m_nodeSet.find(nodePos);
+    m_edges.resize(nodePos);
+    if (it != m_nodeSet.end())
     {
         m_headerInfo.edgessaved += numedges;
         m_headerInfo.nodessaved++;
 
-        return itMap->second;
+        return *it;
     }
-    else
+
+    m_edges.insert(m_edges.end(), ioEdges.begin(), ioEdges.end());
+    m_nodeSet.insert(nodePos);
+    m_headerInfo.edgesused += numedges;
+    m_headerInfo.nodesused++;
+
+    return nodePos;
+}
+
+
+void CompDic::registerPendingNodes(unsigned int iDepth)
+{
+    for (unsigned int i = m_lastWord.size(); i > iDepth; --i)
     {
-        unsigned int node_pos = m_headerInfo.edgesused;
-        m_hashMap[edges] = m_headerInfo.edgesused;
-        m_headerInfo.edgesused += numedges;
-        m_headerInfo.nodesused++;
-        writeNode(&edges.front(), numedges, outFile);
+        m_pendingNodes[i - 1].back().ptr =
+            registerNode(m_pendingNodes[i]);
+        m_pendingNodes[i].clear();
+    }
+}
+
 
-        return node_pos;
+void CompDic::addWord(const wstring &iWord, unsigned int iLineNb,
+                      const Header &iHeader)
+{
+    // Length of the prefix common with the previous word
+    unsigned int common = 0;
+    while (common < iWord.size() && common < m_lastWord.size() &&
+           iWord[common] == m_lastWord[common])
+    {
+        ++common;
     }
+    // The algorithm needs sorted words
+    if (common == iWord.size() ||
+        (common < m_lastWord.size() && iWord[common] < m_lastWord[common]))
+    {
+        ostringstream oss;
+        oss << fmt(_("Error in the word list on line %1%: the words must be "
+                     "sorted, without duplicates")) % iLineNb;
+        throw DicException(oss.str());
+    }
+
+    // The nodes after the common prefix of the previous word are complete
+    registerPendingNodes(common);
+
+    if (m_pendingNodes.size() < iWord.size() + 1)
+        m_pendingNodes.resize(iWord.size() + 1);
+
+    // Add the new suffix
+    DicEdge newEdge = {0, 0, 0, 0};
+    for (unsigned int i = common; i < iWord.size(); ++i)
+    {
+        if (iWord[i] == kSeparatorChar)
+            newEdge.chr = DIC_GADDAG_SEPARATOR;
+        else
+        {
+            try
+            {
+                newEdge.chr = iHeader.getCodeFromChar(iWord[i]);
+            }
+            catch (DicException &e)
+            {
+                // If an invalid character is found, be specific about the problem
+                ostringstream oss;
+                oss << fmt(_("Error in the word list on line %1%, col %2%: %3%"))
+                    % iLineNb % (1 + i) % e.what() << endl;
+                throw DicException(oss.str());
+            }
+        }
+        m_pendingNodes[i].push_back(newEdge);
+    }
+    // Mark edge as word
+    m_pendingNodes[iWord.size() - 1].back().term = 1;
+
+    m_headerInfo.nwords++;
+    m_lastWord = iWord;
+}
+
+
+unsigned int CompDic::finishWords()
+{
+    registerPendingNodes(0);
+    unsigned int root = 0;
+    if (!m_pendingNodes.empty())
+    {
+        root = registerNode(m_pendingNodes[0]);
+        m_pendingNodes[0].clear();
+    }
+    m_lastWord.clear();
+    return root;
+}
+
+
+#if HAVE_BOOST_THREAD
+/// Functor running CompDic::buildSubtree() in a thread
+class SubtreeBuilder
+{
+public:
+    SubtreeBuilder(CompDic &ioBuilder, const vector<wstring> &iWordList,
+                   unsigned int iBegin, unsigned int iEnd,
+                   const Header &iHeader)
+        : m_builder(ioBuilder), m_wordList(iWordList),
+          m_begin(iBegin), m_end(iEnd), m_header(iHeader)
+    {
+    }
+
+    void operator()() const
+    {
+        m_builder.buildSubtree(m_wordList, m_begin, m_end, m_header);
+    }
+
+private:
+    CompDic &m_builder;
+    const vector<wstring> &m_wordList;
+    unsigned int m_begin;
+    unsigned int m_end;
+    const Header &m_header;
+};
+#endif
+
+
+void CompDic::buildSubtree(const vector<wstring> &iWordList,
+                           unsigned int iBegin, unsigned int iEnd,
+                           const Header &iHeader)
+{
+    try
+    {
+        // Special node zero - no edges
+        DicEdge specialNode = {0, 0, 0, 0};
+        specialNode.last = 1;
+        m_edges.push_back(specialNode);
+
+        for (unsigned int i = iBegin; i < iEnd; ++i)
+        {
+            addWord(iWordList[i], i + 1, iHeader);
+        }
+        // Only the root node is left pending
+        registerPendingNodes(0);
+    }
+    catch (const std::exception &e)
+    {
+        // The exception is rethrown by the main thread
+        m_error = e.what();
+    }
+}
+
+
+void CompDic::mergeSubtree(const CompDic &iSubtree, vector<DicEdge> &ioRootEdges)
+{
+    // Register the nodes of the subtree in the same order as the serial
+    // algorithm would have done: the children are always registered before
+    // their parent, so their global position is already known
+    vector<uint32_t> localToGlobal(iSubtree.m_edges.size(), 0);
+    vector<DicEdge> edges;
+    unsigned int pos = 1;
+    while (pos < iSubtree.m_edges.size())
+    {
+        const unsigned int nodePos = pos;
+        edges.clear();
+        do
+        {
+            edges.push_back(iSubtree.m_edges[pos]);
+            edges.back().ptr = localToGlobal[edges.back().ptr];
+        } while (!iSubtree.m_edges[pos++].last);
+        localToGlobal[nodePos] = registerNode(edges);
+    }
+
+    BOOST_FOREACH(DicEdge edge, iSubtree.m_pendingNodes[0])
+    {
+        edge.ptr = localToGlobal[edge.ptr];
+        ioRootEdges.push_back(edge);
+    }
+
+    // The nodes already shared in the subtree are not seen by registerNode()
+    m_headerInfo.nwords += iSubtree.m_headerInfo.nwords;
+    m_headerInfo.nodessaved += iSubtree.m_headerInfo.nodessaved;
+    m_headerInfo.edgessaved += iSubtree.m_headerInfo.edgessaved;
+}
+
+
+unsigned int CompDic::buildAutomaton(const vector<wstring> &iWordList,
+                                     const Header &iHeader)
+{
+#if HAVE_BOOST_THREAD
+    if (m_nbThreads > 1 && !iWordList.empty())
+    {
+        // Split the word list in parts of similar sizes, without splitting
+        // the words starting with the same letter (they must be in the
+        // same subtree)
+        vector<unsigned int> bounds(1, 0);
+        const unsigned int partSize = iWordList.size() / m_nbThreads + 1;
+        for (unsigned int i = 1; i < iWordList.size(); ++i)
+        {
+            if (iWordList[i][0] != iWordList[i - 1][0] &&
+                i - bounds.back() >= partSize)
+            {
+                bounds.push_back(i);
+            }
+        }
+        bounds.push_back(iWordList.size());
+
+        const unsigned int nbParts = bounds.size() - 1;
+        LOG_DEBUG(fmt("Building the automaton with %1% threads") % nbParts);
+        vector<CompDic*> subtrees(nbParts);
+        boost::thread_group threads;
+        for (unsigned int i = 0; i < nbParts; ++i)
+        {
+            subtrees[i] = new CompDic;
+            subtrees[i]->m_headerInfo.nativeEdges = m_headerInfo.nativeEdges;
+            threads.create_thread(SubtreeBuilder(*subtrees[i], iWordList,
+                                                 bounds[i], bounds[i + 1],
+                                                 iHeader));
+        }
+        threads.join_all();
+
+        // Merge the subtrees, in order
+        vector<DicEdge> rootEdges;
+        string error;
+        for (unsigned int i = 0; i < nbParts; ++i)
+        {
+            if (error.empty())
+            {
+                if (subtrees[i]->m_error.empty())
+                    mergeSubtree(*subtrees[i], rootEdges);
+                else
+                    error = subtrees[i]->m_error;
+            }
+            delete subtrees[i];
+        }
+        if (!error.empty())
+            throw DicException(error);
+
+        return registerNode(rootEdges);
+    }
+#endif
+
+    for (unsigned int i = 0; i < iWordList.size(); ++i)
+    {
+        addWord(iWordList[i], i + 1, iHeader);
+    }
+    return finishWords();
 }
 
 
@@ -341,8 +748,11 @@ Header CompDic::generateDawg(const string &iWordListFile,
                              const string &iDicName)
 {
     m_headerInfo.dicName = wfl(iDicName);
-    // We are not (yet) able to build the GADDAG format
-    m_headerInfo.dawg = true;
+
+    if (m_streaming && !m_headerInfo.dawg)
+        throw DicException(_("The GADDAG cannot be built from a streamed word list"));
+    if (m_streaming && m_anagrams)
+        throw DicException(_("The anagram index cannot be built from a streamed word list"));
 
     // Open the output file
     ofstream outFile(iDawgFile.c_str(), ios::out | ios::binary | ios::trunc);
@@ -353,49 +763,129 @@ Header CompDic::generateDawg(const string &iWordListFile,
         throw DicException(oss.str());
     }
 
-    const clock_t startLoadTime = clock();
     vector<wstring> wordList;
-    loadWordList(iWordListFile, wordList);
-    const clock_t endLoadTime = clock();
-    m_loadTime = 1.0 * (endLoadTime - startLoadTime) / CLOCKS_PER_SEC;
-
-    if (wordList.empty())
+    boost::scoped_ptr<WordListReader> wordReader;
+    if (m_streaming)
+    {
+        wordReader.reset(new WordListReader(iWordListFile, m_headerInfo.letters));
+    }
+    else
     {
-        throw DicException(_("The word list is empty!"));
+        const clock_t startLoadTime = clock();
+        loadWordList(iWordListFile, wordList);
+        const clock_t endLoadTime = clock();
+        m_loadTime = 1.0 * (endLoadTime - startLoadTime) / CLOCKS_PER_SEC;
+
+        if (wordList.empty())
+        {
+            throw DicException(_("The word list is empty!"));
+        }
     }
 
     // Write the header a first time, to reserve the space in the file
     Header tempHeader = writeHeader(outFile);
 
+    // Special node zero - no edges
     DicEdge specialNode = {0, 0, 0, 0};
     specialNode.last = 1;
-    // Temporary variable to avoid a warning when compiling with -O2
-    // (there is no warning with -O0... g++ bug?)
-    writeNode(&specialNode, 1, outFile);
+    m_edges.push_back(specialNode);
 
-    vector<wstring>::const_iterator firstWord = wordList.begin();
-    wstring::const_iterator initialPos = firstWord->begin();
-
-    // Call makeNode with null (relative to stringbuf) prefix;
-    // Initialize string to null; Put index of start node on output
+    // Add all the words, and put index of start node on output.
+    // The wall clock time is measured, as the build may use several threads
     DicEdge rootNode = {0, 0, 0, 0};
-    m_endString = m_stringBuf;
-    const clock_t startBuildTime = clock();
-    rootNode.ptr = makeNode(outFile, tempHeader,
-                            firstWord, wordList.end(),
-                            initialPos, m_endString);
-    // Reuse the temporary variable
-    writeNode(&rootNode, 1, outFile);
-    const clock_t endBuildTime = clock();
-    m_buildTime = 1.0 * (endBuildTime - startBuildTime) / CLOCKS_PER_SEC;
-
-    // Write the header again, now that it is complete
+    const ptime startBuildTime = microsec_clock::universal_time();
+    if (m_streaming)
+    {
+        unsigned int lineNb = 0;
+        wstring word;
+        while (wordReader->readWord(word, lineNb))
+        {
+            addWord(word, lineNb, tempHeader);
+        }
+        if (m_headerInfo.nwords == 0)
+        {
+            throw DicException(_("The word list is empty!"));
+        }
+        rootNode.ptr = finishWords();
+    }
+    else
+    {
+        rootNode.ptr = buildAutomaton(wordList, tempHeader);
+    }
+    m_edges.push_back(rootNode);
     m_headerInfo.root = m_headerInfo.edgesused;
+
+    if (!m_headerInfo.dawg)
+    {
+        // The GADDAG follows the DAWG, after its root edge
+        m_headerInfo.edgesused++;
+
+        vector<wstring> gaddagList;
+        buildGaddagList(wordList, gaddagList);
+        // The words are only counted once
+        const uint32_t nbWords = m_headerInfo.nwords;
+
+        DicEdge gaddagRootNode = {0, 0, 0, 0};
+        gaddagRootNode.ptr = buildAutomaton(gaddagList, tempHeader);
+        m_edges.push_back(gaddagRootNode);
+        m_headerInfo.gaddagRoot = m_headerInfo.edgesused;
+        m_headerInfo.nwords = nbWords;
+    }
+
+    vector<uint8_t> anagramIndex;
+    if (m_anagrams)
+    {
+        buildAnagramIndex(wordList, tempHeader, anagramIndex);
+        m_headerInfo.anagramSize = anagramIndex.size();
+    }
+    vector<uint32_t> wordCounts;
+    if (m_wordCounts)
+    {
+        buildWordCounts(wordCounts);
+        m_headerInfo.wordCountsSize = wordCounts.size() * sizeof(uint32_t);
+    }
+    vector<uint32_t> childMasks;
+    if (m_childMasks)
+    {
+        buildChildMasks(childMasks);
+        m_headerInfo.childMasksSize = childMasks.size() * sizeof(uint32_t);
+    }
+    const time_duration buildDuration =
+        microsec_clock::universal_time() - startBuildTime;
+    m_buildTime = buildDuration.total_microseconds() / 1000000.0;
+
+    // Write the header again, now that it is complete, and the edges
     const Header finalHeader = writeHeader(outFile);
+    writeEdges(outFile);
+
+    // The anagram index directly follows the edges
+    if (!anagramIndex.empty())
+    {
+        outFile.write((const char*)&anagramIndex.front(), anagramIndex.size());
+        if (!outFile.good())
+            throw DicException(_("Error when writing the anagram index"));
+    }
+
+    // The word counts follow the anagram index
+    if (!wordCounts.empty())
+    {
+        outFile.write((const char*)&wordCounts.front(),
+                      wordCounts.size() * sizeof(uint32_t));
+        if (!outFile.good())
+            throw DicException(_("Error when writing the word counts"));
+    }
+
+    // The child masks follow the word counts
+    if (!childMasks.empty())
+    {
+        outFile.write((const char*)&childMasks.front(),
+                      childMasks.size() * sizeof(uint32_t));
+        if (!outFile.good())
+            throw DicException(_("Error when writing the child masks"));
+    }
 
     // Clean up
     outFile.close();
 
     return finalHeader;
 }
-
@@ -25,7 +25,7 @@
 #include <vector>
 #include <string>
 #include <iosfwd>
-#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
 #include "header.h"
 #include "dic_internals.h"
@@ -38,13 +38,29 @@ class Header;
 using namespace std;
 
 //#define DEBUG_OUTPUT
-#define CHECK_RECURSION
 
 
 class CompDic
 {
     DEFINE_LOGGER();
-    typedef boost::unordered_map<vector<DicEdge>, unsigned int> HashMap;
+
+    /// Hash of a node of m_edges, given the position of its first edge
+    struct NodeHash
+    {
+        NodeHash(const vector<DicEdge> *iEdges) : m_edges(iEdges) {}
+        size_t operator()(uint32_t iNode) const;
+        const vector<DicEdge> *m_edges;
+    };
+
+    /// Equality of 2 nodes of m_edges, given the positions of their first edges
+    struct NodeEqual
+    {
+        NodeEqual(const vector<DicEdge> *iEdges) : m_edges(iEdges) {}
+        bool operator()(uint32_t iNode1, uint32_t iNode2) const;
+        const vector<DicEdge> *m_edges;
+    };
+
+    typedef boost::unordered_set<uint32_t, NodeHash, NodeEqual> NodeSet;
 
 public:
     CompDic();
@@ -69,6 +85,68 @@ public:
 
     unsigned getLettersCount() const { return m_headerInfo.letters.size(); }
 
+    /**
+     * Write the edges in the byte order of the current machine instead of
+     * the portable big-endian order. Such dictionaries can be loaded without
+     * any conversion (and mapped in memory) on machines with the same byte
+     * order, but they cannot be read by Eliot versions older than 2.2.
+     */
+    void setNativeEdges(bool iNative) { m_headerInfo.nativeEdges = iNative; }
+
+    /**
+     * Also generate a GADDAG, stored after the DAWG in the same file.
+     * The GADDAG is used to speed up the search of the best moves on the
+     * board, and the resulting file cannot be read by Eliot versions
+     * older than 2.2.
+     */
+    void setGaddag(bool iGaddag) { m_headerInfo.dawg = !iGaddag; }
+
+    /**
+     * Read the word list progressively while building the dictionary,
+     * instead of loading and sorting it in memory first. The word list
+     * must then be sorted (after conversion to upper case), without
+     * duplicates, and the GADDAG cannot be generated.
+     * The memory used is then proportional to the size of the generated
+     * dictionary, instead of the size of the word list.
+     */
+    void setStreaming(bool iStreaming) { m_streaming = iStreaming; }
+
+    /**
+     * Also generate an anagram index, stored after the edges. It associates
+     * the sorted letters of the words to the words themselves, so that the
+     * anagrams of a rack are found with a hash lookup instead of a walk of
+     * the whole DAWG. It cannot be generated from a streamed word list, and
+     * the resulting file cannot be read by Eliot versions older than 2.2.
+     */
+    void setAnagramIndex(bool iAnagrams) { m_anagrams = iAnagrams; }
+
+    /**
+     * Also store the word counts of the edges, after the anagram index.
+     * They give the position of each word in the dictionary, and the number
+     * of words starting with a given prefix, without enumerating the words
+     * (see Dictionary::getWordId()). The resulting file cannot be read by
+     * Eliot versions older than 2.2.
+     */
+    void setWordCounts(bool iWordCounts) { m_wordCounts = iWordCounts; }
+
+    /**
+     * Also store the codes of the children of each node, after the word
+     * counts. They give the position of a child in constant time (see
+     * Dictionary::getSuccByCode()), without building anything when the
+     * dictionary is loaded. The resulting file cannot be read by Eliot
+     * versions older than 2.2.
+     */
+    void setChildMasks(bool iChildMasks) { m_childMasks = iChildMasks; }
+
+    /**
+     * Number of threads used to build the dictionary (1 by default).
+     * The subtrees of groups of first letters are built in parallel, and
+     * then merged in order, so the result is identical to a serial build.
+     * This has no effect in streaming mode, or if Eliot was compiled
+     * without Boost.Thread.
+     */
+    void setThreads(unsigned int iNbThreads) { m_nbThreads = iNbThreads; }
+
     /**
      * Generate the dictionary. You must have called addLetter() before
      * (once for each letter of the word list, and possible once for the
@@ -85,24 +163,50 @@ public:
     // Statistics
     double getLoadTime() const { return m_loadTime; }
     double getBuildTime() const { return m_buildTime; }
-#ifdef CHECK_RECURSION
-    double getMaxRecursion() const { return m_maxRec; }
-#endif
+
+    /**
+     * Build the subtree of the words of iWordList in [iBegin, iEnd[, in
+     * this (empty) builder. The edges of the root node are left in
+     * m_pendingNodes[0]. In case of error, the message is saved in
+     * m_error (this method is executed in a separate thread).
+     */
+    void buildSubtree(const vector<wstring> &iWordList,
+                      unsigned int iBegin, unsigned int iEnd,
+                      const Header &iHeader);
 
 private:
+    // Prevent from copying the builder (m_nodeSet refers to m_edges)
+    CompDic(const CompDic&);
+    CompDic &operator=(const CompDic&);
+
     DictHeaderInfo m_headerInfo;
 
-    HashMap m_hashMap;
+    bool m_streaming;
+    bool m_anagrams;
+    bool m_wordCounts;
+    bool m_childMasks;
+    unsigned int m_nbThreads;
+
+    /// Error which occurred in buildSubtree()
+    string m_error;
+
+    /**
+     * All the edges generated so far (in host byte order), at the same
+     * position as in the generated file
+     */
+    vector<DicEdge> m_edges;
 
-    /// Space for the current string
-    wchar_t *m_stringBuf;
-    /// Point to the end of the string
-    wchar_t *m_endString;
-#ifdef CHECK_RECURSION
-    map<int, vector<DicEdge> > m_mapForDepth;
-    int m_currentRec;
-    int m_maxRec;
-#endif
+    /// Registered nodes (identified by the position of their first edge)
+    NodeSet m_nodeSet;
+
+    /**
+     * Nodes which are not complete yet: m_pendingNodes[i] contains the
+     * edges of the node reached after the first i letters of the last
+     * added word. Only the last edge of each node can still change.
+     */
+    vector<vector<DicEdge> > m_pendingNodes;
+    /// Last word added to the pending nodes
+    wstring m_lastWord;
 
     double m_loadTime;
     double m_buildTime;
@@ -110,44 +214,109 @@ private:
 
     /**
      * Read the word list stored in iFileName, convert it to wide chars,
-     * and return it (in the oWordList argument).
+     * and return it (in the oWordList argument), sorted and without
+     * duplicates.
      * In case of problem, an exception is thrown.
      * @param iFileName: Name (and path) of the file containing the word list.
      * @param oWordList: Word list
      */
     void loadWordList(const string &iFileName, vector<wstring> &oWordList);
 
+    /**
+     * Build the list of GADDAG entries corresponding to the given
+     * (sorted) word list. The returned list is sorted, and the separator
+     * is represented by kSeparatorChar.
+     * @param iWordList: Word list
+     * @param oGaddagList: GADDAG entries
+     */
+    void buildGaddagList(const vector<wstring> &iWordList,
+                         vector<wstring> &oGaddagList) const;
+
+    /**
+     * Build the anagram index of the given word list, ready to be written
+     * after the edges (see Dictionary::loadAnagramIndex() for the format).
+     * @param iWordList: Word list
+     * @param iHeader: temporary header, used only to do the conversion
+     *      between the (wide) chars and their corresponding internal code
+     * @param oIndex: serialized index, with a size multiple of 4 bytes
+     */
+    void buildAnagramIndex(const vector<wstring> &iWordList,
+                           const Header &iHeader,
+                           vector<uint8_t> &oIndex) const;
+
+    /**
+     * Compute the word counts of the edges of the DAWG (up to its root edge),
+     * ready to be written after the anagram index: the count of an edge is
+     * the number of words going through it or through the edges preceding
+     * it in the same node. The children nodes must precede their parents
+     * in m_edges.
+     * @param oCounts: one count for each edge of the DAWG, in the byte order
+     *      of the edges
+     */
+    void buildWordCounts(vector<uint32_t> &oCounts) const;
+
+    /**
+     * Compute the child masks of the nodes of m_edges, ready to be written
+     * after the word counts (see Dictionary::loadChildMasks() for the format).
+     * The edges of each node must be sorted by code.
+     * @param oMasks: the integers of the section, in the byte order of the edges
+     */
+    void buildChildMasks(vector<uint32_t> &oMasks) const;
+
     Header writeHeader(ostream &outFile) const;
 
     /**
-     * Change the endianness of the pointed edges (if needed),
-     * and write them to the given ostream.
-     * @param ioEdges: array of edges
-     * @param num: number of edges in the array
+     * Change the endianness of the edges of m_edges (if needed, i.e. unless
+     * native edges were requested), and write them to the given ostream.
      * @param outFile: stream where to write the edges
      */
-    void writeNode(DicEdge *ioEdges, unsigned int num, ostream &outFile);
-
-    /**
-     * MakeNode takes a prefix (as position relative to m_stringBuf) and
-     * returns the index of the start node of a dawg that recognizes all
-     * the words beginning with that prefix.  String is a pointer (relative
-     * to m_stringBuf) indicating how much of iPrefix is matched in the
-     * input.
-     * @param outfile: stream where to write the nodes
-     * @param iHeader: temporary header, used only to do the conversion between
-     *      the (wide) chars and their corresponding internal code
-     * @param itCurrWord: iterator on the word list
-     * @param itLastWord: end of the word list
-     * @param itPosInWord: iterator on the letters of the current word
-     * @param iPrefix: prefix to work on
-     * @return the index of a DAWG matching all the words with prefix iPrefix
-     */
-    unsigned int makeNode(ostream &outFile, const Header &iHeader,
-                          vector<wstring>::const_iterator &itCurrWord,
-                          const vector<wstring>::const_iterator &itLastWord,
-                          wstring::const_iterator &itPosInWord,
-                          const wchar_t *iPrefix);
+    void writeEdges(ostream &outFile) const;
+
+    /**
+     * Sort the given edges, and return the position of an identical node
+     * if there is already one. Otherwise, append the node to m_edges and
+     * return its position. The special node 0 is returned for an empty node.
+     * @param ioEdges: edges of the node (sorted by this method)
+     * @return the position of the node
+     */
+    unsigned int registerNode(vector<DicEdge> &ioEdges);
+
+    /**
+     * Add a word to the automaton being built (Daciuk's incremental
+     * algorithm for sorted input). The words must be added in increasing
+     * order. The nodes which cannot change anymore are registered
+     * (i.e. minimized) immediately.
+     * @param iWord: word to add
+     * @param iLineNb: line of the word, for the error messages
+     * @param iHeader: temporary header, used only to do the conversion
+     *      between the (wide) chars and their corresponding internal code
+     */
+    void addWord(const wstring &iWord, unsigned int iLineNb,
+                 const Header &iHeader);
+
+    /**
+     * Register all the pending nodes, and reset the state of addWord(),
+     * to allow building another automaton.
+     * @return the position of the root node of the automaton
+     */
+    unsigned int finishWords();
+
+    /// Register the pending nodes deeper than the given depth
+    void registerPendingNodes(unsigned int iDepth);
+
+    /**
+     * Build the automaton recognizing the given (sorted) words, using
+     * several threads if requested.
+     * @return the position of the root node of the automaton
+     */
+    unsigned int buildAutomaton(const vector<wstring> &iWordList,
+                                const Header &iHeader);
+
+    /**
+     * Register all the nodes built by iSubtree (see buildSubtree()),
+     * and append the edges of its root node to ioRootEdges
+     */
+    void mergeSubtree(const CompDic &iSubtree, vector<DicEdge> &ioRootEdges);
 
 };
 
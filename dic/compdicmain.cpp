@@ -130,6 +130,19 @@ void printUsage(const string &iBinaryName)
          << _("                          The words must be in alphabetical order, without duplicates") << endl
          << _("  -o, --output <string>   Path to the generated compressed dictionary file") << endl
          << _("Other options:") << endl
+         << _("  -n, --native            Store the edges in the byte order of this machine, for faster") << endl
+         << _("                          loading (not readable by Eliot versions older than 2.2)") << endl
+         << _("  -g, --gaddag            Also store a GADDAG, for a faster search of the moves on the") << endl
+         << _("                          board (not readable by Eliot versions older than 2.2)") << endl
+         << _("  -s, --stream            Read the word list progressively instead of loading it in memory") << endl
+         << _("                          (it must then be sorted in upper case; incompatible with --gaddag)") << endl
+         << _("  -a, --anagrams          Also store an anagram index, for a faster search of the anagrams") << endl
+         << _("                          (not readable by Eliot versions older than 2.2; incompatible with --stream)") << endl
+         << _("  -w, --word-counts       Also store the number of words below each edge, to number the words") << endl
+         << _("                          and count them without enumeration (not readable by Eliot versions older than 2.2)") << endl
+         << _("  -m, --child-masks       Also store the letters of the children of each node, for faster") << endl
+         << _("                          lookups (not readable by Eliot versions older than 2.2)") << endl
+         << _("  -t, --threads <int>     Number of threads used to build the dictionary (default: 1)") << endl
          << _("  -h, --help              Print this help and exit") << endl
          << _("Example:") << endl
          << "  " << iBinaryName << _(" -d 'ODS 5.0' -l letters.txt -i ods5.txt -o ods5.dawg") << endl
@@ -194,9 +207,16 @@ int main(int argc, char* argv[])
         {"letters", required_argument, NULL, 'l'},
         {"input", required_argument, NULL, 'i'},
         {"output", required_argument, NULL, 'o'},
+        {"native", no_argument, NULL, 'n'},
+        {"gaddag", no_argument, NULL, 'g'},
+        {"stream", no_argument, NULL, 's'},
+        {"anagrams", no_argument, NULL, 'a'},
+        {"word-counts", no_argument, NULL, 'w'},
+        {"child-masks", no_argument, NULL, 'm'},
+        {"threads", required_argument, NULL, 't'},
         {0, 0, 0, 0}
     };
-    static const char short_options[] = "hd:l:i:o:";
+    static const char short_options[] = "hd:l:i:o:ngsawmt:";
 
     bool found_d = false;
     bool found_l = false;
@@ -235,6 +255,27 @@ int main(int argc, char* argv[])
                     found_o = true;
                     outFileName = optarg;
                     break;
+                case 'n':
+                    builder.setNativeEdges(true);
+                    break;
+                case 'g':
+                    builder.setGaddag(true);
+                    break;
+                case 's':
+                    builder.setStreaming(true);
+                    break;
+                case 'a':
+                    builder.setAnagramIndex(true);
+                    break;
+                case 'w':
+                    builder.setWordCounts(true);
+                    break;
+                case 'm':
+                    builder.setChildMasks(true);
+                    break;
+                case 't':
+                    builder.setThreads(std::max(1, atoi(optarg)));
+                    break;
             }
         }
 
@@ -255,9 +296,6 @@ int main(int argc, char* argv[])
 
         cout << fmt(_(" Load time: %1% s")) % builder.getLoadTime() << endl;
         cout << fmt(_(" Compression time: %1% s")) % builder.getBuildTime() << endl;
-#ifdef CHECK_RECURSION
-        cout << fmt(_(" Maximum recursion level reached: %1%")) % builder.getMaxRecursion() << endl;
-#endif
         return 0;
     }
     catch (const BaseException &e)
@@ -28,16 +28,12 @@
 #include <cctype>
 #include <boost/foreach.hpp>
 
-// For ntohl & Co.
-#ifdef WIN32
-#   include <winsock2.h>
-#else
-#    if HAVE_NETINET_IN_H
-#       include <netinet/in.h>
-#    endif
-#    if HAVE_ARPA_INET_H
-#       include <arpa/inet.h>
-#    endif
+#if HAVE_SYS_MMAN_H && HAVE_MMAP
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   define DIC_USE_MMAP 1
 #endif
 
 #include "dic.h"
@@ -46,6 +42,7 @@
 #include "dic_internals.h"
 #include "encoding.h"
 #include "tile.h"
+#include "automaton.h"
 
 
 INIT_LOGGER(dic, Dictionary);
@@ -53,9 +50,16 @@ INIT_LOGGER(dic, Dictionary);
 
 const Dictionary *Dictionary::m_dic = NULL;
 
+// Number of regular expressions whose automaton is kept by searchRegExp()
+static const unsigned int kAutomatonCacheSize = 16;
+
 
-Dictionary::Dictionary(const string &iPath)
-    : m_dawg(NULL), m_hasDisplay(false)
+Dictionary::Dictionary(const string &iPath, LoadMode iMode)
+    : m_dawg(NULL), m_mapAddr(NULL), m_mapSize(0),
+      m_anagramIndex(NULL), m_anagramNbBuckets(0), m_anagramBuckets(NULL),
+      m_anagramGroups(NULL), m_anagramData(NULL), m_wordCounts(NULL),
+      m_childIndex(NULL), m_childMasks(NULL),
+      m_hasDisplay(false)
 {
     ifstream file(iPath.c_str(), ios::in | ios::binary);
 
@@ -64,19 +68,38 @@ Dictionary::Dictionary(const string &iPath)
 
     // XXX: we should protect these allocations with auto_ptr
     m_header = new Header(file);
-    m_dawg = new uint32_t[m_header->getNbEdgesUsed() + 1];
 
-    streamsize toRead = (m_header->getNbEdgesUsed() + 1) * sizeof(uint32_t);
-    file.read((char*)m_dawg, toRead);
-    if (file.gcount() != toRead)
+    if (iMode != kLOAD_MMAP ||
+        !mapEdges(iPath, m_header->getEdgesOffset()))
     {
-        delete[] m_dawg;
-        delete m_header;
-        throw DicException("Problem reading dictionary arcs");
+        try
+        {
+            loadEdges(file);
+        }
+        catch (...)
+        {
+            delete m_header;
+            throw;
+        }
     }
 
-    // Handle endianness
-    convertDataToArch();
+    try
+    {
+        loadAnagramIndex(file);
+        loadWordCounts(file);
+        loadChildMasks(file);
+    }
+    catch (...)
+    {
+#ifdef DIC_USE_MMAP
+        if (m_mapAddr != NULL)
+            munmap(m_mapAddr, m_mapSize);
+        else
+#endif
+            delete[] m_dawg;
+        delete m_header;
+        throw;
+    }
 
     initializeTiles();
 
@@ -109,6 +132,7 @@ Dictionary::Dictionary(const string &iPath)
             m_hasDisplay = true;
     }
 
+    m_automatonCache = new AutomatonCache(*this, kAutomatonCacheSize);
 
     m_dic = this;
 }
@@ -116,20 +140,272 @@ Dictionary::Dictionary(const string &iPath)
 
 Dictionary::~Dictionary()
 {
-    delete[] m_dawg;
+#ifdef DIC_USE_MMAP
+    if (m_mapAddr != NULL)
+        munmap(m_mapAddr, m_mapSize);
+    else
+#endif
+        delete[] m_dawg;
     delete m_header;
+    delete m_automatonCache;
+}
+
+
+bool Dictionary::mapEdges(const string &iPath, streamoff iOffset)
+{
+#ifdef DIC_USE_MMAP
+    // Edges stored in another byte order must be converted
+    if (!m_header->hasHostOrderEdges() ||
+        iOffset < 0 || iOffset % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+
+    int fd = open(iPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat statBuf;
+    const size_t edgesSize =
+        (m_header->getNbEdgesUsed() + 1) * sizeof(uint32_t);
+    if (fstat(fd, &statBuf) < 0 ||
+        (size_t)statBuf.st_size < (size_t)iOffset + edgesSize)
+    {
+        // Let the copying code report the truncated file
+        close(fd);
+        return false;
+    }
+
+    void *addr = mmap(NULL, statBuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        LOG_WARN("Cannot map " << iPath << ", reading it instead");
+        return false;
+    }
+
+    m_mapAddr = addr;
+    m_mapSize = statBuf.st_size;
+    m_dawg = reinterpret_cast<const uint32_t*>((const char*)addr + iOffset);
+    LOG_DEBUG("Dictionary edges mapped from " << iPath);
+    return true;
+#else
+    (void)iPath;
+    (void)iOffset;
+    return false;
+#endif
+}
+
+
+void Dictionary::loadEdges(istream &iStream)
+{
+    uint32_t *edges = new uint32_t[m_header->getNbEdgesUsed() + 1];
+
+    streamsize toRead = (m_header->getNbEdgesUsed() + 1) * sizeof(uint32_t);
+    iStream.read((char*)edges, toRead);
+    if (iStream.gcount() != toRead)
+    {
+        delete[] edges;
+        throw DicException("Problem reading dictionary arcs");
+    }
+
+    // Handle endianness
+    convertDataToArch(edges);
+
+    m_dawg = edges;
 }
 
 
-void Dictionary::convertDataToArch()
+void Dictionary::convertDataToArch(uint32_t *ioEdges) const
 {
+    // Native edges written on a machine with the same byte order,
+    // or big-endian edges on a big-endian machine
+    if (m_header->hasHostOrderEdges())
+        return;
+
     for (unsigned int i = 0; i < (m_header->getNbEdgesUsed() + 1); i++)
     {
-        m_dawg[i] = ntohl(m_dawg[i]);
+        ioEdges[i] = swapBytes(ioEdges[i]);
     }
 }
 
 
+void Dictionary::loadAnagramIndex(istream &iStream)
+{
+    const uint32_t size = m_header->getAnagramSize();
+    if (size == 0)
+        return;
+    if (size % sizeof(uint32_t) != 0)
+        throw DicException("Problem reading the anagram index");
+    const unsigned int nbInts = size / sizeof(uint32_t);
+    const size_t offset = m_header->getAnagramOffset();
+
+    const uint32_t *index;
+    if (m_mapAddr != NULL && offset + size <= m_mapSize)
+    {
+        // The mapped edges are in host byte order, and so is the index
+        index = reinterpret_cast<const uint32_t*>((const char*)m_mapAddr + offset);
+    }
+    else
+    {
+        m_anagramBuffer.resize(nbInts);
+        iStream.seekg(offset, ios::beg);
+        iStream.read((char*)&m_anagramBuffer.front(), size);
+        if (iStream.gcount() != (streamsize)size)
+            throw DicException("Problem reading the anagram index");
+        index = &m_anagramBuffer.front();
+    }
+
+    // Check the consistency of the index, converting the integers
+    // on the fly if needed
+    const bool swap = !m_header->hasHostOrderEdges();
+    if (swap)
+        m_anagramBuffer[0] = swapBytes(m_anagramBuffer[0]);
+    const uint32_t nbBuckets = index[0];
+    if (nbBuckets == 0 || (nbBuckets & (nbBuckets - 1)) != 0 ||
+        nbBuckets > nbInts - 2)
+    {
+        throw DicException("Problem reading the anagram index");
+    }
+    if (swap)
+    {
+        for (unsigned int i = 1; i < nbBuckets + 2; ++i)
+            m_anagramBuffer[i] = swapBytes(m_anagramBuffer[i]);
+    }
+    const uint32_t nbGroups = index[nbBuckets + 1];
+    if (nbGroups > nbInts - nbBuckets - 3)
+        throw DicException("Problem reading the anagram index");
+    const unsigned int nbHeaderInts = nbBuckets + nbGroups + 3;
+    if (swap)
+    {
+        for (unsigned int i = nbBuckets + 2; i < nbHeaderInts; ++i)
+            m_anagramBuffer[i] = swapBytes(m_anagramBuffer[i]);
+    }
+    if (index[nbHeaderInts - 1] > (nbInts - nbHeaderInts) * sizeof(uint32_t))
+        throw DicException("Problem reading the anagram index");
+    // Both the buckets and the groups must be in increasing order
+    for (unsigned int i = 1; i < nbHeaderInts - 1; ++i)
+    {
+        if (i != nbBuckets + 1 && index[i] > index[i + 1])
+            throw DicException("Problem reading the anagram index");
+    }
+
+    m_anagramIndex = index;
+    m_anagramNbBuckets = nbBuckets;
+    m_anagramBuckets = index + 1;
+    m_anagramGroups = index + nbBuckets + 2;
+    m_anagramData = reinterpret_cast<const dic_code_t*>(index + nbHeaderInts);
+}
+
+
+void Dictionary::loadWordCounts(istream &iStream)
+{
+    const uint32_t size = m_header->getWordCountsSize();
+    if (size == 0)
+        return;
+    // Only the edges of the DAWG have a count (the GADDAG follows its root)
+    const unsigned int nbEdges = m_header->getRoot() + 1;
+    if (nbEdges > m_header->getNbEdgesUsed() + 1 ||
+        size != nbEdges * sizeof(uint32_t))
+    {
+        throw DicException("Problem reading the word counts");
+    }
+    const size_t offset = m_header->getWordCountsOffset();
+
+    const uint32_t *counts;
+    if (m_mapAddr != NULL && offset + size <= m_mapSize)
+    {
+        // The mapped edges are in host byte order, and so are the counts
+        counts = reinterpret_cast<const uint32_t*>((const char*)m_mapAddr + offset);
+    }
+    else
+    {
+        m_wordCountsBuffer.resize(nbEdges);
+        iStream.seekg(offset, ios::beg);
+        iStream.read((char*)&m_wordCountsBuffer.front(), size);
+        if (iStream.gcount() != (streamsize)size)
+            throw DicException("Problem reading the word counts");
+        if (!m_header->hasHostOrderEdges())
+        {
+            for (unsigned int i = 0; i < nbEdges; ++i)
+                m_wordCountsBuffer[i] = swapBytes(m_wordCountsBuffer[i]);
+        }
+        counts = &m_wordCountsBuffer.front();
+    }
+
+    // The root edge leads to all the words
+    if (counts[m_header->getRoot()] != m_header->getNbWords())
+        throw DicException("Problem reading the word counts");
+    m_wordCounts = counts;
+}
+
+
+void Dictionary::loadChildMasks(istream &iStream)
+{
+    const uint32_t size = m_header->getChildMasksSize();
+    if (size == 0)
+        return;
+    const unsigned int nbEdges = m_header->getNbEdgesUsed() + 1;
+    const unsigned int nbIndexInts = 2 * ((nbEdges + 31) / 32);
+    const unsigned int nbInts = size / sizeof(uint32_t);
+    if (size % (2 * sizeof(uint32_t)) != 0 || nbInts < nbIndexInts)
+        throw DicException("Problem reading the child masks");
+    const size_t offset = m_header->getChildMasksOffset();
+
+    const uint32_t *index;
+    if (m_mapAddr != NULL && offset + size <= m_mapSize)
+    {
+        // The mapped edges are in host byte order, and so are the masks
+        index = reinterpret_cast<const uint32_t*>((const char*)m_mapAddr + offset);
+    }
+    else
+    {
+        m_childMasksBuffer.resize(nbInts);
+        iStream.seekg(offset, ios::beg);
+        iStream.read((char*)&m_childMasksBuffer.front(), size);
+        if (iStream.gcount() != (streamsize)size)
+            throw DicException("Problem reading the child masks");
+        if (!m_header->hasHostOrderEdges())
+        {
+            for (unsigned int i = 0; i < nbInts; ++i)
+                m_childMasksBuffer[i] = swapBytes(m_childMasksBuffer[i]);
+        }
+        index = &m_childMasksBuffer.front();
+    }
+
+    // The ranks of the blocks must match their flags, and the last one
+    // the number of masks
+    uint32_t nbNodes = 0;
+    for (unsigned int i = 0; i < nbIndexInts; i += 2)
+    {
+        if (index[i] != nbNodes)
+            throw DicException("Problem reading the child masks");
+        nbNodes += popCount64(index[i + 1]);
+    }
+    if (nbIndexInts + 2 * nbNodes != nbInts)
+        throw DicException("Problem reading the child masks");
+
+    m_childIndex = index;
+    m_childMasks = index + nbIndexInts;
+}
+
+
+inline bool Dictionary::getChildMask(const dic_elt_t &iNode, uint64_t &oMask) const
+{
+    if (m_childIndex == NULL)
+        return false;
+    const uint32_t *block = m_childIndex + 2 * (iNode / 32);
+    const uint32_t bit = (uint32_t)1 << (iNode % 32);
+    if ((block[1] & bit) == 0)
+        return false;
+    // The rank of the node gives the position of its mask
+    const uint32_t *mask = m_childMasks + 2 * (block[0] + popCount64(block[1] & (bit - 1)));
+    oMask = mask[0] | ((uint64_t)mask[1] << 32);
+    return true;
+}
+
+
 void Dictionary::initializeTiles()
 {
     // "Activate" the dictionary by giving the header to the Tile class
@@ -234,6 +510,64 @@ dic_elt_t Dictionary::getRoot() const
 }
 
 
+bool Dictionary::hasGaddag() const
+{
+    return m_header->getType() == Header::kGADDAG;
+}
+
+
+dic_elt_t Dictionary::getGaddagRoot() const
+{
+    return m_header->getGaddagRoot();
+}
+
+
+dic_elt_t Dictionary::getSuccByCode(const dic_elt_t &e, dic_code_t iCode) const
+{
+    const dic_elt_t node = getEdgeAt(e)->ptr;
+    if (node == 0)
+        return 0;
+
+    uint64_t mask;
+    if (getChildMask(node, mask))
+    {
+        // The children are sorted by code: the position of the wanted
+        // child is the number of smaller codes present in the node
+        const uint64_t bit = (uint64_t)1 << iCode;
+        if ((mask & bit) == 0)
+            return 0;
+        return node + popCount64(mask & (bit - 1));
+    }
+
+    const DicEdge *edgePtr = getEdgeAt(node);
+    do
+    {
+        if (edgePtr->chr == iCode)
+            return edgePtr - getEdgeAt(0);
+    } while (!(*edgePtr++).last);
+    return 0;
+}
+
+
+uint64_t Dictionary::getSuccMask(const dic_elt_t &e) const
+{
+    const dic_elt_t node = getEdgeAt(e)->ptr;
+    if (node == 0)
+        return 0;
+    uint64_t mask;
+    if (getChildMask(node, mask))
+        return mask;
+
+    mask = 0;
+    const DicEdge *edgePtr = getEdgeAt(node);
+    do
+    {
+        mask |= (uint64_t)1 << edgePtr->chr;
+    } while (!(*edgePtr++).last);
+    return mask;
+}
+
+
 dic_code_t Dictionary::getCode(const dic_elt_t &e) const
 {
     return reinterpret_cast<const DicEdge*>(m_dawg + e)->chr;
@@ -260,58 +594,108 @@ bool Dictionary::isEndOfWord(const dic_elt_t &e) const
 
 unsigned int Dictionary::lookup(const dic_elt_t &root, const dic_code_t *s) const
 {
-    unsigned int p;
-    dic_elt_t rootCopy = root;
-begin:
-    if (! *s)
-        return rootCopy;
-    if (! getSucc(rootCopy))
-        return 0;
-    p = getSucc(rootCopy);
-    do
+    dic_elt_t p = root;
+    for (; *s && p; ++s)
+        p = getSuccByCode(p, *s);
+    return p;
+}
+
+
+unsigned int Dictionary::charLookup(const dic_elt_t &iRoot, const wchar_t *s) const
+{
+    dic_elt_t p = iRoot;
+    for (; *s && p; ++s)
     {
-        if (getCode(p) == *s)
-        {
-            rootCopy = p;
-            s++;
-            goto begin;
-        }
-        else if (isLast( p))
-        {
+        // Characters without code cannot match
+        const unsigned int code = m_header->findCodeFromChar(*s);
+        if (code == 0)
             return 0;
-        }
-        p = getNext(p);
-    } while (1);
+        p = getSuccByCode(p, code);
+    }
+    return p;
+}
 
-    return 0;
+
+unsigned int Dictionary::getWordsBefore(const dic_elt_t &iEdge) const
+{
+    // The first edge of a node follows the last edge of another node
+    return getEdgeAt(iEdge - 1)->last ? 0 : m_wordCounts[iEdge - 1];
 }
 
 
-unsigned int Dictionary::charLookup(const dic_elt_t &iRoot, const wchar_t *s) const
+unsigned int Dictionary::getWordsThrough(const dic_elt_t &iEdge) const
+{
+    return m_wordCounts[iEdge] - getWordsBefore(iEdge);
+}
+
+
+unsigned int Dictionary::getWordId(const wstring &iWord) const
 {
-    unsigned int p;
-    dic_elt_t rootCopy = iRoot;
-begin:
-    if (! *s)
-        return rootCopy;
-    if (! getSucc(rootCopy))
+    if (m_wordCounts == NULL)
+        throw DicException("Dictionary::getWordId: the dictionary has no word counts");
+    if (iWord.empty() || !validateLetters(iWord))
         return 0;
-    p = getSucc(rootCopy);
-    do
+
+    // The words before iWord are the words going through the preceding
+    // edges of each node of its path, and its prefixes
+    unsigned int nbBefore = 0;
+    dic_elt_t edge = getRoot();
+    for (unsigned int i = 0; i < iWord.size(); ++i)
     {
-        if (getChar(p) == *s)
-        {
-            rootCopy = p;
-            s++;
-            goto begin;
-        }
-        else if (isLast(p))
-        {
+        if (isEndOfWord(edge))
+            ++nbBefore;
+        edge = getSuccByCode(edge, m_header->getCodeFromChar(iWord[i]));
+        if (edge == 0)
             return 0;
-        }
-        p = getNext(p);
-    } while (1);
+        nbBefore += getWordsBefore(edge);
+    }
+    return isEndOfWord(edge) ? nbBefore + 1 : 0;
+}
 
-    return 0;
+
+wstring Dictionary::getWordFromId(unsigned int iId) const
+{
+    if (m_wordCounts == NULL)
+        throw DicException("Dictionary::getWordFromId: the dictionary has no word counts");
+    if (iId == 0 || iId > m_header->getNbWords())
+        throw DicException("Dictionary::getWordFromId: invalid word ID");
+
+    // Number of words to skip, starting from the current node
+    unsigned int nbSkipped = iId - 1;
+    wstring word;
+    dic_elt_t edge = getSucc(getRoot());
+    while (edge != 0)
+    {
+        // The counts increase along the edges of the node
+        while (m_wordCounts[edge] <= nbSkipped)
+            ++edge;
+        nbSkipped -= getWordsBefore(edge);
+        word += m_header->getCharFromCode(getCode(edge));
+        if (isEndOfWord(edge))
+        {
+            if (nbSkipped == 0)
+                return word;
+            --nbSkipped;
+        }
+        edge = getSucc(edge);
+    }
+    throw DicException("Dictionary::getWordFromId: inconsistent word counts");
 }
 
+
+unsigned int Dictionary::countWordsWithPrefix(const wstring &iPrefix) const
+{
+    if (m_wordCounts == NULL)
+        throw DicException("Dictionary::countWordsWithPrefix: the dictionary has no word counts");
+    if (!validateLetters(iPrefix))
+        return 0;
+
+    dic_elt_t edge = getRoot();
+    for (unsigned int i = 0; i < iPrefix.size(); ++i)
+    {
+        edge = getSuccByCode(edge, m_header->getCodeFromChar(iPrefix[i]));
+        if (edge == 0)
+            return 0;
+    }
+    return getWordsThrough(edge);
+}
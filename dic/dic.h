@@ -23,6 +23,7 @@
 #define DIC_H_
 
 #include <stdint.h>
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <map>
@@ -38,7 +39,14 @@ using namespace std;
  */
 #define DIC_WORD_MAX 16
 
+/**
+ * Code of the separator used in the GADDAG, between the reversed prefix
+ * of a word and the rest of the word. It cannot be the code of a letter.
+ */
+#define DIC_GADDAG_SEPARATOR 0
+
 class Header;
+class AutomatonCache;
 typedef unsigned int dic_elt_t;
 typedef unsigned char dic_code_t;
 struct params_cross_t;
@@ -58,15 +66,50 @@ struct DicEdge;
 typedef wstring wdstring;
 typedef wstring wistring;
 
+
+/**
+ * Receiver of the words found by a dictionary search, one at a time
+ * (see Dictionary::searchRegExp())
+ */
+class WordReceiver
+{
+public:
+    virtual ~WordReceiver() {}
+
+    /**
+     * Called for each found word, in the order of the dictionary
+     * @param iWord: found word, in display form. The string is reused
+     *      by the search, so it must be copied if it needs to be kept
+     * @return false to stop the search, true to continue it
+     */
+    virtual bool receive(const wdstring &iWord) = 0;
+};
+
+
 class Dictionary
 {
     DEFINE_LOGGER();
 public:
+    /// How the edges of the dictionary are brought into memory
+    enum LoadMode
+    {
+        /// Read the edges into a private buffer
+        kLOAD_COPY,
+        /**
+         * Map the file read-only and use the edges in place, so that the
+         * pages are shared between all the processes using the same file.
+         * When the edges are not stored in the byte order of the machine,
+         * the dictionary silently falls back to kLOAD_COPY.
+         */
+        kLOAD_MMAP
+    };
+
     /**
      * Dictionary creation and loading from a file
      * @param path: compressed dictionary path
+     * @param iMode: loading strategy for the edges
      */
-    Dictionary(const string &path);
+    Dictionary(const string &path, LoadMode iMode = kLOAD_MMAP);
 
     /// Destructor
     ~Dictionary();
@@ -89,6 +132,9 @@ public:
     /** Give access to the dictionary header */
     const Header& getHeader() const { return *m_header; }
 
+    /// Return true if the edges are used directly from a mapping of the file
+    bool isMapped() const { return m_mapAddr != NULL; }
+
     /**
      * Check whether all the given letters are present in the dictionary,
      * or are one of the other accepted letters.
@@ -163,6 +209,49 @@ public:
      */
     dic_elt_t getRoot() const;
 
+    /// Return true if the dictionary also contains a GADDAG
+    bool hasGaddag() const;
+
+    /**
+     * Returns the root of the GADDAG (only valid if hasGaddag() is true).
+     * In the GADDAG, each word is reachable once for each of its letters,
+     * as the reversed prefix ending with this letter, followed by the
+     * DIC_GADDAG_SEPARATOR edge, followed by the rest of the word.
+     * @returns root element
+     */
+    dic_elt_t getGaddagRoot() const;
+
+    /// Return true if the dictionary contains an anagram index
+    bool hasAnagramIndex() const { return m_anagramIndex != NULL; }
+
+    /// Return true if the dictionary contains the word counts of the edges
+    bool hasWordCounts() const { return m_wordCounts != NULL; }
+
+    /**
+     * Return the ID of the given word, i.e. its position in the dictionary
+     * (from 1 to the number of words, in alphabetical order), or 0 if the
+     * word is not in the dictionary. The IDs are dense, so they can be used
+     * instead of the words themselves to index tables.
+     * The word counts are needed (see hasWordCounts()).
+     * @throw DicException if the dictionary has no word counts
+     */
+    unsigned int getWordId(const wstring &iWord) const;
+
+    /**
+     * Return the word with the given ID (see getWordId())
+     * @throw DicException if the dictionary has no word counts, or if
+     *      the ID is not valid
+     */
+    wstring getWordFromId(unsigned int iId) const;
+
+    /**
+     * Return the number of words starting with the given letters (the
+     * letters themselves included, if they form a word), without
+     * enumerating them
+     * @throw DicException if the dictionary has no word counts
+     */
+    unsigned int countWordsWithPrefix(const wstring &iPrefix) const;
+
     /**
      * Returns the next available neighbor (see isLast())
      * @returns next dictionary element at the same depth
@@ -177,6 +266,22 @@ public:
      */
     dic_elt_t getSucc(const dic_elt_t &elt) const;
 
+    /**
+     * Returns the element with the given code among the successors
+     * of the given element
+     * @params elt : current dictionary element
+     * @params iCode : code of the wanted successor
+     * @returns the successor, or 0 if there is no such successor
+     */
+    dic_elt_t getSuccByCode(const dic_elt_t &elt, dic_code_t iCode) const;
+
+    /**
+     * Returns the set of codes of the successors of the given element,
+     * as a bit mask (bit i is set if a successor has the code i)
+     * @params elt : current dictionary element
+     */
+    uint64_t getSuccMask(const dic_elt_t &elt) const;
+
     /**
      * Find the dictionary element matching the pattern starting
      * from the given root node by walking the dictionary tree
@@ -215,6 +320,19 @@ public:
      */
     bool searchWord(const wstring &iWord) const;
 
+    /**
+     * Search for several words in the dictionary at once (see searchWord()).
+     * The words are converted to codes only once, and sorted, so that the
+     * common prefixes of consecutive words are walked only once.
+     * @param iWords: lookup words
+     * @param oValid: results (oValid[i] is true if iWords[i] is valid)
+     * @param iNbThreads: number of threads checking different parts of
+     *      iWords (0 means one per processor). Only one thread is used for
+     *      small lists, or if Eliot was compiled without Boost.Thread.
+     */
+    void searchWords(const vector<wstring> &iWords, vector<bool> &oValid,
+                     unsigned int iNbThreads = 1) const;
+
     /**
      * Search for benjamins
      * @param iWord: letters
@@ -233,12 +351,24 @@ public:
     void searchRacc(const wstring &iWord, vector<wdstring> &oWordList,
                     unsigned int iMaxResults = 0) const;
 
+    /**
+     * Search for all the words ending with the given letters (including
+     * the letters themselves, if they form a word)
+     * @param iSuffix: letters
+     * @param oWordList: results
+     * @param iMaxResults: maximum number of returned results (0 means no limit)
+     */
+    void searchEnding(const wstring &iSuffix, vector<wdstring> &oWordList,
+                      unsigned int iMaxResults = 0) const;
+
     /**
      * Search for all feasible word with "rack" plus one letter
      * XXX: the key in the map is the internal code, because it allows an easy
      * iteration in the map in the order of the dictionary letters.
      * Maybe a more powerful structure should be provided, to hide the internal
      * chars to the caller.
+     * The anagram index is used when the dictionary has one (and when the
+     * rack contains at most 1 joker), otherwise the whole DAWG is walked.
      *
      * @param iRack: letters
      * @param oWordlist: results (grouped by code of the added character)
@@ -250,11 +380,17 @@ public:
                     bool joker) const;
 
     /**
-     * Search for words matching a regular expression
+     * Search for words matching a regular expression.
+     * The automata of the last expressions are cached, so repeating a
+     * search (e.g. with other lengths or limit) only walks the dictionary.
      * @param iRegexp: regular expression
      * @param oWordList: results
      * @param iList: parameters for the search (?)
      * @param iMaxResults: maximum number of returned results (0 means no limit)
+     * @param iNbThreads: number of threads searching different parts of the
+     *      dictionary (0 means one per processor). The results are the same
+     *      as with a single thread. Only one thread is used if Eliot was
+     *      compiled without Boost.Thread.
      * @return true if all the matching words were returned, false otherwise
      *      (i.e. if the maximum number of results was reached, and there are
      *      additional results)
@@ -264,7 +400,61 @@ public:
                       vector<wdstring> &oWordList,
                       unsigned int iMinLength,
                       unsigned int iMaxLength,
-                      unsigned int iMaxResults = 0) const;
+                      unsigned int iMaxResults = 0,
+                      unsigned int iNbThreads = 1) const;
+
+    /**
+     * Search for words matching a regular expression, giving them to
+     * ioReceiver as they are found (see also RegexpCursor, to retrieve
+     * the words page by page). Nothing is allocated for the words
+     * which are not accepted, so this is well suited to broad patterns
+     * or to searches without limit.
+     * @param iRegexp: regular expression
+     * @param ioReceiver: receiver of the matching words
+     * @return true if all the matching words were given to ioReceiver,
+     *      false if it stopped the search
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    bool searchRegExp(const wstring &iRegexp,
+                      WordReceiver &ioReceiver,
+                      unsigned int iMinLength,
+                      unsigned int iMaxLength) const;
+
+    /**
+     * Count the words matching a regular expression, without building
+     * them. If the dictionary has word counts, the words below a point
+     * from which all the words are accepted (e.g. after "AB" for "AB.*")
+     * are not even walked.
+     * @param iRegexp: regular expression
+     * @param iMinLength: minimum length of the words
+     * @param iMaxLength: maximum length of the words (0 means no limit)
+     * @return the number of matching words
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    unsigned int countRegExp(const wstring &iRegexp,
+                             unsigned int iMinLength = 1,
+                             unsigned int iMaxLength = 0) const;
+
+    /**
+     * Search for words matching a regular expression, and which can be
+     * made with the tiles of the given rack (each letter of the word uses
+     * a tile of the rack, or a joker). The dictionary is walked only along
+     * the words allowed by both the expression and the rack.
+     * @param iRegexp: regular expression
+     * @param iRack: letters of the rack, with '?' for the jokers
+     * @param oWordList: results
+     * @param iMaxResults: maximum number of returned results (0 means no limit)
+     * @return true if all the matching words were returned, false otherwise
+     *      (i.e. if the maximum number of results was reached, and there are
+     *      additional results)
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    bool searchRegExpRack(const wstring &iRegexp,
+                          const wstring &iRack,
+                          vector<wdstring> &oWordList,
+                          unsigned int iMinLength,
+                          unsigned int iMaxLength,
+                          unsigned int iMaxResults = 0) const;
 
 private:
     // Prevent from copying the dictionary!
@@ -272,7 +462,49 @@ private:
     Dictionary(const Dictionary&);
 
     Header *m_header;
-    uint32_t *m_dawg;
+    const uint32_t *m_dawg;
+
+    /// Start of the file mapping, or NULL if the edges were copied
+    void *m_mapAddr;
+    /// Length of the file mapping
+    size_t m_mapSize;
+
+    /**
+     * Anagram index (see loadAnagramIndex()), or NULL if the dictionary
+     * doesn't have one. It points either to the file mapping or to
+     * m_anagramBuffer.
+     */
+    const uint32_t *m_anagramIndex;
+    /// Copy of the anagram index, when it is not mapped
+    vector<uint32_t> m_anagramBuffer;
+    /// Number of buckets of the anagram index (a power of 2)
+    uint32_t m_anagramNbBuckets;
+    /// First group of each bucket (and end of the last bucket)
+    const uint32_t *m_anagramBuckets;
+    /// Offset in m_anagramData of each group (and end of the last group)
+    const uint32_t *m_anagramGroups;
+    /// Sorted codes and words of the groups
+    const dic_code_t *m_anagramData;
+
+    /**
+     * Word counts of the edges (see loadWordCounts()), or NULL if the
+     * dictionary doesn't have them. They point either to the file mapping
+     * or to m_wordCountsBuffer.
+     */
+    const uint32_t *m_wordCounts;
+    /// Copy of the word counts, when they are not mapped
+    vector<uint32_t> m_wordCountsBuffer;
+
+    /**
+     * Child masks of the nodes (see loadChildMasks()), or NULL if the
+     * dictionary doesn't have them. They point either to the file mapping
+     * or to m_childMasksBuffer.
+     */
+    const uint32_t *m_childIndex;
+    /// Codes of the children of each node, after m_childIndex
+    const uint32_t *m_childMasks;
+    /// Copy of the child masks, when they are not mapped
+    vector<uint32_t> m_childMasksBuffer;
 
     /**
      * Letters of the dictionary, both in uppercase and lowercase
@@ -308,9 +540,103 @@ private:
      */
     bool m_hasDisplay;
 
+    /// Automata of the last regular expressions searched
+    AutomatonCache *m_automatonCache;
+    friend class RegexpCursor;
+
     static const Dictionary *m_dic;
 
-    void convertDataToArch();
+    /**
+     * Try to map the edges directly from the file.
+     * @param iPath: compressed dictionary path
+     * @param iOffset: position of the first edge in the file
+     * @return true if the edges are now available in m_dawg, false if the
+     *      caller must read them with loadEdges()
+     */
+    bool mapEdges(const string &iPath, streamoff iOffset);
+
+    /// Read the edges from the stream into a newly allocated array
+    void loadEdges(istream &iStream);
+
+    void convertDataToArch(uint32_t *ioEdges) const;
+
+    /**
+     * Load the anagram index following the edges, if there is one.
+     * The index is made of 32 bits integers (in the byte order of the
+     * edges) followed by bytes:
+     *  - the number of buckets B (a power of 2)
+     *  - B + 1 integers: the first group of each bucket (and the total
+     *    number G of groups)
+     *  - G + 1 integers: the offset of each group in the data (and the
+     *    size of the data)
+     *  - the data: for each group, the sorted codes of its words, followed
+     *    by the codes of its words (in the order of the codes), each one
+     *    terminated by a 0.
+     * A group is in the bucket given by hashCodes() of its sorted codes.
+     * @param iStream: stream on the dictionary, used if it is not mapped
+     */
+    void loadAnagramIndex(istream &iStream);
+
+    /**
+     * Load the word counts following the anagram index, if any.
+     * There is one count for each edge of the DAWG, i.e. up to its root
+     * edge (in the byte order of the edges):
+     * the number of words going through this edge or through the edges
+     * preceding it in the same node. This gives in constant time the
+     * number of words below an edge (see getWordsThrough()), and the number
+     * of words before it in the node (see getWordsBefore()).
+     * @param iStream: stream on the dictionary, used if it is not mapped
+     */
+    void loadWordCounts(istream &iStream);
+
+    /**
+     * Load the child masks following the word counts, if any.
+     * They are made of 32 bits integers (in the byte order of the edges):
+     *  - for each block of 32 edges, the number of indexed nodes starting
+     *    before the block, and the flags of the edges of the block starting
+     *    an indexed node
+     *  - for each indexed node, the mask of the codes of its edges (low 32
+     *    bits, then high 32 bits).
+     * Only the nodes with several edges are indexed: the others are found
+     * as fast by scanning their edge.
+     * @param iStream: stream on the dictionary, used if it is not mapped
+     */
+    void loadChildMasks(istream &iStream);
+
+    /**
+     * Set oMask to the mask of the codes of the edges of the given node,
+     * if it is indexed (see loadChildMasks()). Since the edges of a node
+     * are sorted by code, this gives the position of a child in constant
+     * time. Return false if the node must be scanned instead.
+     */
+    bool getChildMask(const dic_elt_t &iNode, uint64_t &oMask) const;
+
+    /// Number of words going through the edges preceding the given one in its node
+    unsigned int getWordsBefore(const dic_elt_t &iEdge) const;
+
+    /// Number of words going through the given edge
+    unsigned int getWordsThrough(const dic_elt_t &iEdge) const;
+
+    /// Helper for countRegExp()
+    unsigned int countRegexpRec(const struct params_count_t &params,
+                                unsigned int state,
+                                const DicEdge *edgeptr,
+                                unsigned int depth) const;
+
+    /**
+     * Add to oWords the words whose sorted codes are iSortedCodes (which
+     * must be terminated by a 0), using the anagram index.
+     * The words are returned as pointers to 0-terminated codes.
+     */
+    void findAnagrams(const dic_code_t *iSortedCodes, unsigned int iLen,
+                      vector<const dic_code_t*> &oWords) const;
+
+    /// Helper for search7pl1(), when there is an anagram index
+    /// (and at most 1 joker)
+    void search7pl1Index(const char *iCounts, unsigned int iNbJokers,
+                         unsigned int iLen,
+                         map<unsigned int, vector<wdstring> > &oWordList) const;
+
     void initializeTiles();
 
     /**
@@ -323,15 +649,55 @@ private:
     /// Helper for search7pl1()
     void searchWordByLen(struct params_7plus1_t &params,
                          int i, const DicEdge *edgeptr) const;
+    /// Helper for searchWordByLen(), once a letter is chosen for edgeptr
+    void searchWordByLenFound(struct params_7plus1_t &params,
+                              int i, const DicEdge *edgeptr) const;
+
+    /**
+     * Find all the prefixes of iMinLen to iMaxLen letters which form a
+     * word when followed by iSuffix, as codes in the order of the codes.
+     * When the dictionary has a GADDAG, the words are found with a single
+     * walk of the GADDAG from the reversed suffix (the GADDAG contains
+     * each word reversed, followed by the separator). Otherwise, the
+     * suffix is searched after each prefix of the DAWG.
+     */
+    void searchPrefixes(const wstring &iSuffix,
+                        unsigned int iMinLen, unsigned int iMaxLen,
+                        vector<string> &oPrefixes) const;
+
+    /// Helpers for searchPrefixes()
+    void searchPrefixesGaddag(struct params_prefixes_t &params,
+                              const dic_elt_t &iElt) const;
+    void searchPrefixesDawg(struct params_prefixes_t &params,
+                            const dic_elt_t &iElt) const;
 
     /// Helper for searchRegExp()
-    void searchRegexpRec(const struct params_regexp_t &params,
+    void searchRegexpRec(struct params_regexp_t &params,
                          int state,
-                         const DicEdge *edgeptr,
-                         vector<wdstring> &oWordList,
-                         unsigned int iMaxResults,
-                         const wdstring &iCurrWord = L"",
-                         unsigned int iNbChars = 0) const;
+                         const DicEdge *edgeptr) const;
+
+    /// Helper for searchRegExpRack()
+    void searchRegexpRackRec(struct params_regexp_t &params,
+                             int state,
+                             const DicEdge *edgeptr) const;
+
+    /**
+     * Helper for the parallel version of searchRegExp(): execute the tasks
+     * of ioTasks until there is no more needed task (this method is
+     * executed in several threads at the same time)
+     */
+    void searchRegexpTasks(struct regexp_tasks_t &ioTasks) const;
+    friend class RegexpSearcher;
+
+    /**
+     * Helper for searchWords(): check the words of iWords in
+     * [iBegin, iEnd[, and set the corresponding bytes of oValid
+     * (this method may be executed in several threads at the same time)
+     */
+    void searchWordsRange(const vector<wstring> &iWords,
+                          unsigned int iBegin, unsigned int iEnd,
+                          vector<uint8_t> &oValid) const;
+    friend class WordsSearcher;
 };
 
 #endif /* _DIC_H_ */
@@ -36,6 +36,9 @@
  *  + nodes             \n
  *  +                   \n
  *  firstnode (= root)  \n
+ *  ----------------    \n
+ *  anagram index       \n
+ *  (optional)          \n
  *  ----------------
  */
 
@@ -53,5 +56,40 @@ struct __attribute__ ((packed)) DicEdge
       }
 };
 
+/// Reverse the byte order of a 32 bits value
+static inline uint32_t swapBytes(uint32_t iVal)
+{
+    return ((iVal & 0x000000FF) << 24) | ((iVal & 0x0000FF00) << 8) |
+           ((iVal & 0x00FF0000) >> 8) | ((iVal & 0xFF000000) >> 24);
+}
+
+/// Return the number of bits set in a 64 bits value
+static inline unsigned int popCount64(uint64_t iVal)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(iVal);
+#else
+    unsigned int count = 0;
+    for (; iVal; iVal &= iVal - 1)
+        ++count;
+    return count;
+#endif
+}
+
+/**
+ * Hash of a sequence of codes (FNV-1a), used to find the groups
+ * of the anagram index
+ */
+static inline uint32_t hashCodes(const uint8_t *iCodes, unsigned int iLen)
+{
+    uint32_t hash = 2166136261U;
+    for (unsigned int i = 0; i < iLen; ++i)
+    {
+        hash ^= iCodes[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 #endif /* _DIC_INTERNALS_H */
 
@@ -19,10 +19,20 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  *****************************************************************************/
 
+#include "config.h"
+
 #include <cstdlib>
 #include <cstring>
 #include <cwchar>
 #include <cwctype>
+#include <algorithm>
+#include <set>
+#include <boost/foreach.hpp>
+
+#if HAVE_BOOST_THREAD
+#   include <boost/thread/thread.hpp>
+#   include <boost/thread/mutex.hpp>
+#endif
 
 #include "dic_internals.h"
 #include "dic_exception.h"
@@ -31,23 +41,32 @@
 #include "encoding.h"
 #include "regexp.h"
 #include "automaton.h"
-#include "grammar.h"
 
 
 static const unsigned int DEFAULT_VECT_ALLOC = 100;
 
+// Parallel version of searchRegExp(): minimal number of parts of the
+// dictionary for each thread, and maximal length of the prefixes defining
+// these parts
+static const unsigned int kRegexpTasksPerThread = 8;
+static const unsigned int kMaxRegexpSplitDepth = 3;
+
+// Parallel version of searchWords(): minimal number of words for each thread
+static const unsigned int kMinWordsPerThread = 1000;
+
 
 const DicEdge* Dictionary::seekEdgePtr(const wchar_t* s, const DicEdge *eptr) const
 {
     if (*s)
     {
-        const DicEdge *p = getEdgeAt(eptr->ptr);
-        do
-        {
-            if (p->chr == getHeader().getCodeFromChar(*s))
-                return seekEdgePtr(s + 1, p);
-        } while (!(*p++).last);
-        return getEdgeAt(0);
+        // Characters without code cannot match
+        const unsigned int code = getHeader().findCodeFromChar(*s);
+        if (code == 0)
+            return getEdgeAt(0);
+        const dic_elt_t succ = getSuccByCode(eptr - getEdgeAt(0), code);
+        if (succ == 0)
+            return getEdgeAt(0);
+        return seekEdgePtr(s + 1, getEdgeAt(succ));
     }
     else
         return eptr;
@@ -56,14 +75,177 @@ const DicEdge* Dictionary::seekEdgePtr(const wchar_t* s, const DicEdge *eptr) co
 
 bool Dictionary::searchWord(const wstring &iWord) const
 {
-    if (!validateLetters(iWord))
-        return false;
-
+    // The invalid letters are detected during the walk
     const DicEdge *e = seekEdgePtr(iWord.c_str(), getEdgeAt(getRoot()));
     return e->term;
 }
 
 
+/// Order of the words by codes, given the positions of their codes
+class CodesLess
+{
+public:
+    CodesLess(const char *iCodes, const vector<unsigned int> &iStarts)
+        : m_codes(iCodes), m_starts(iStarts) {}
+
+    bool operator()(unsigned int iWord1, unsigned int iWord2) const
+    {
+        return strcmp(m_codes + m_starts[iWord1], m_codes + m_starts[iWord2]) < 0;
+    }
+
+private:
+    const char *m_codes;
+    const vector<unsigned int> &m_starts;
+};
+
+
+void Dictionary::searchWordsRange(const vector<wstring> &iWords,
+                                  unsigned int iBegin, unsigned int iEnd,
+                                  vector<uint8_t> &oValid) const
+{
+    // Convert the words to codes, stored one after the other (terminated
+    // by a 0) instead of being allocated separately. The invalid words
+    // are not checked.
+    string codes;
+    vector<unsigned int> starts;
+    vector<unsigned int> positions;
+    starts.reserve(iEnd - iBegin);
+    positions.reserve(iEnd - iBegin);
+    for (unsigned int i = iBegin; i < iEnd; ++i)
+    {
+        oValid[i] = false;
+        const wstring &word = iWords[i];
+        const unsigned int start = codes.size();
+        BOOST_FOREACH(wchar_t chr, word)
+        {
+            const unsigned int code = getHeader().findCodeFromChar(chr);
+            if (code == 0)
+                break;
+            codes.push_back(code);
+        }
+        if (word.empty() || codes.size() - start != word.size())
+        {
+            codes.resize(start);
+            continue;
+        }
+        codes.push_back(0);
+        starts.push_back(start);
+        positions.push_back(i);
+    }
+    const char *data = codes.c_str();
+
+    // Sort the words by codes, unless they already are
+    vector<unsigned int> order(starts.size());
+    bool sorted = true;
+    for (unsigned int k = 0; k < order.size(); ++k)
+    {
+        order[k] = k;
+        if (k > 0 && sorted && CodesLess(data, starts)(k, k - 1))
+            sorted = false;
+    }
+    if (!sorted)
+        std::sort(order.begin(), order.end(), CodesLess(data, starts));
+
+    // path[i] is the edge reached after the first i letters of the
+    // previous word (as long as they are in the dictionary)
+    vector<const DicEdge*> path;
+    path.reserve(DIC_WORD_MAX + 1);
+    path.push_back(getEdgeAt(getRoot()));
+    const char *previous = NULL;
+    BOOST_FOREACH(unsigned int k, order)
+    {
+        const char *word = data + starts[k];
+        // Restart from the end of the common prefix with the previous word
+        unsigned int depth = 0;
+        if (previous != NULL)
+        {
+            while (depth + 1 < path.size() && word[depth] != 0 &&
+                   previous[depth] == word[depth])
+            {
+                ++depth;
+            }
+        }
+        path.resize(depth + 1);
+        for (; word[depth] != 0; ++depth)
+        {
+            const dic_elt_t succ =
+                getSuccByCode(path.back() - getEdgeAt(0), word[depth]);
+            if (succ == 0)
+                break;
+            path.push_back(getEdgeAt(succ));
+        }
+        oValid[positions[k]] = word[depth] == 0 && path.back()->term;
+        previous = word;
+    }
+}
+
+
+#if HAVE_BOOST_THREAD
+/// Functor running Dictionary::searchWordsRange() in a thread
+class WordsSearcher
+{
+public:
+    WordsSearcher(const Dictionary &iDic, const vector<wstring> &iWords,
+                  unsigned int iBegin, unsigned int iEnd,
+                  vector<uint8_t> &oValid)
+        : m_dic(iDic), m_words(iWords), m_begin(iBegin), m_end(iEnd),
+        m_valid(oValid)
+    {
+    }
+
+    void operator()() const
+    {
+        m_dic.searchWordsRange(m_words, m_begin, m_end, m_valid);
+    }
+
+private:
+    const Dictionary &m_dic;
+    const vector<wstring> &m_words;
+    unsigned int m_begin;
+    unsigned int m_end;
+    vector<uint8_t> &m_valid;
+};
+#endif
+
+
+void Dictionary::searchWords(const vector<wstring> &iWords,
+                             vector<bool> &oValid,
+                             unsigned int iNbThreads) const
+{
+    // One byte per word, so that several threads can write their results
+    // at the same time (which is not possible with a vector<bool>)
+    vector<uint8_t> valid(iWords.size());
+    const unsigned int nbWords = iWords.size();
+
+#if HAVE_BOOST_THREAD
+    if (iNbThreads == 0)
+        iNbThreads = boost::thread::hardware_concurrency();
+    const unsigned int nbThreads =
+        min(iNbThreads, max(1u, nbWords / kMinWordsPerThread));
+    if (nbThreads > 1)
+    {
+        // Each thread checks a contiguous part of the words
+        boost::thread_group threads;
+        for (unsigned int i = 1; i < nbThreads; ++i)
+        {
+            const unsigned int begin = (uint64_t)nbWords * i / nbThreads;
+            const unsigned int end = (uint64_t)nbWords * (i + 1) / nbThreads;
+            threads.create_thread(WordsSearcher(*this, iWords, begin, end, valid));
+        }
+        // The current thread works too
+        searchWordsRange(iWords, 0, nbWords / nbThreads, valid);
+        threads.join_all();
+    }
+    else
+#endif
+    {
+        searchWordsRange(iWords, 0, nbWords, valid);
+    }
+
+    oValid.assign(valid.begin(), valid.end());
+}
+
+
 /**
  * Global variables for searchWordByLen:
  *
@@ -75,12 +257,16 @@ bool Dictionary::searchWord(const wstring &iWord) const
 
 struct params_7plus1_t
 {
-    unsigned int added_code;
-    wdstring added_display;
-    map<unsigned int, vector<wdstring> > *results;
+    /// Number of letters of the rack
     int search_len;
-    wchar_t search_wordtst[DIC_WORD_MAX];
-    char search_letters[63];
+    /// Code of the added letter, or 0 if it is not used yet
+    unsigned int added_code;
+    /// Codes of the current word
+    char search_codes[DIC_WORD_MAX + 2];
+    /// Available letters of the rack, indexed by code (the jokers have the code 0)
+    char search_letters[DIC_LETTERS + 1];
+    /// Found words (as codes), grouped by code of the added letter
+    map<unsigned int, set<string> > results;
 };
 
 void Dictionary::searchWordByLen(struct params_7plus1_t &params,
@@ -92,56 +278,155 @@ void Dictionary::searchWordByLen(struct params_7plus1_t &params,
         /* the test is false only when reach the end-node */
         if (edgeptr->chr)
         {
-            /* is the letter available in search_letters */
-            if (params.search_letters[edgeptr->chr])
+            const unsigned int code = edgeptr->chr;
+            params.search_codes[i] = code;
+            /*
+             * Use the letter of the rack if it is available. Otherwise,
+             * use a joker, or make this letter the added one.
+             * Using a joker or the added letter when the letter is in
+             * the rack would only find the same words again (the letter
+             * of the rack would be used later instead).
+             */
+            if (params.search_letters[code])
             {
-                params.search_wordtst[i] = getHeader().getCharFromCode(edgeptr->chr);
-                params.search_letters[edgeptr->chr] --;
-                if (i == params.search_len)
-                {
-                    if (edgeptr->term)
-                    {
-                        // Add the solution
-                        vector<wdstring> &sols = (*params.results)[params.added_code];
-                        if (sols.empty() || sols.back() != params.search_wordtst)
-                            sols.push_back(convertToDisplay(params.search_wordtst));
-                    }
-                }
-                else
-                {
-                    searchWordByLen(params, i + 1, getEdgeAt(edgeptr->ptr));
-                }
-                params.search_letters[edgeptr->chr] ++;
-                params.search_wordtst[i] = L'\0';
+                params.search_letters[code] --;
+                searchWordByLenFound(params, i, edgeptr);
+                params.search_letters[code] ++;
             }
-
-            /* the letter is of course available if we have a joker available */
-            if (params.search_letters[0])
+            else
             {
-                params.search_wordtst[i] = getHeader().getCharFromCode(edgeptr->chr);
-                params.search_letters[0] --;
-                if (i == params.search_len)
+                if (params.search_letters[0])
                 {
-                    if (edgeptr->term)
-                    {
-                        // Add the solution
-                        vector<wdstring> &sols = (*params.results)[params.added_code];
-                        if (sols.empty() || sols.back() != params.search_wordtst)
-                            sols.push_back(convertToDisplay(params.search_wordtst));
-                    }
+                    params.search_letters[0] --;
+                    searchWordByLenFound(params, i, edgeptr);
+                    params.search_letters[0] ++;
                 }
-                else
+                if (params.added_code == 0)
                 {
-                    searchWordByLen(params, i + 1, getEdgeAt(edgeptr->ptr));
+                    params.added_code = code;
+                    searchWordByLenFound(params, i, edgeptr);
+                    params.added_code = 0;
                 }
-                params.search_letters[0] ++;
-                params.search_wordtst[i] = L'\0';
             }
         }
     } while (! (*edgeptr++).last);
 }
 
 
+void Dictionary::searchWordByLenFound(struct params_7plus1_t &params,
+                                      int i, const DicEdge *edgeptr) const
+{
+    // Number of letters used so far, including the added one
+    const int nbUsed = i + 1;
+    if (edgeptr->term)
+    {
+        // The words must use all the letters of the rack, plus
+        // optionally the added letter
+        if (nbUsed == params.search_len + (params.added_code ? 1 : 0))
+        {
+            params.results[params.added_code].insert(
+                    string(params.search_codes, nbUsed));
+        }
+    }
+    if (nbUsed <= params.search_len)
+        searchWordByLen(params, i + 1, getEdgeAt(edgeptr->ptr));
+}
+
+
+void Dictionary::findAnagrams(const dic_code_t *iSortedCodes, unsigned int iLen,
+                              vector<const dic_code_t*> &oWords) const
+{
+    const uint32_t bucket =
+        hashCodes(iSortedCodes, iLen) & (m_anagramNbBuckets - 1);
+    for (uint32_t g = m_anagramBuckets[bucket];
+         g < m_anagramBuckets[bucket + 1]; ++g)
+    {
+        const dic_code_t *group = m_anagramData + m_anagramGroups[g];
+        if (strcmp((const char*)group, (const char*)iSortedCodes) != 0)
+            continue;
+        // The words follow the sorted codes, and have the same length
+        const dic_code_t *end = m_anagramData + m_anagramGroups[g + 1];
+        for (const dic_code_t *word = group + iLen + 1;
+             word + iLen < end; word += iLen + 1)
+        {
+            oWords.push_back(word);
+        }
+        return;
+    }
+}
+
+
+/// Order of the words of the anagram index (i.e. order of the codes)
+static bool codesLess(const dic_code_t *iCodes1, const dic_code_t *iCodes2)
+{
+    return strcmp((const char*)iCodes1, (const char*)iCodes2) < 0;
+}
+
+static bool codesEqual(const dic_code_t *iCodes1, const dic_code_t *iCodes2)
+{
+    return strcmp((const char*)iCodes1, (const char*)iCodes2) == 0;
+}
+
+
+void Dictionary::search7pl1Index(const char *iCounts, unsigned int iNbJokers,
+                                 unsigned int iLen,
+                                 map<unsigned int, vector<wdstring> > &oWordList) const
+{
+    const unsigned int maxCode = getHeader().getMaxCode();
+
+    // Sorted codes of the letters of the rack (without the jokers)
+    dic_code_t rackCodes[DIC_WORD_MAX + 1];
+    unsigned int nbRackCodes = 0;
+    for (unsigned int code = 1; code <= maxCode; ++code)
+    {
+        for (int i = 0; i < iCounts[code]; ++i)
+            rackCodes[nbRackCodes++] = code;
+    }
+
+    // Sorted codes looked up in the index, with room for the added letter,
+    // the joker, and the terminating 0
+    dic_code_t codes[DIC_WORD_MAX + 2];
+    vector<const dic_code_t*> words;
+    // The added code 0 corresponds to the anagrams of the rack itself
+    for (unsigned int added = 0; added <= maxCode; ++added)
+    {
+        words.clear();
+        // Try all the values of the joker, if any (0 stands for an
+        // absent joker)
+        const unsigned int firstJoker = iNbJokers ? 1 : 0;
+        const unsigned int lastJoker = iNbJokers ? maxCode : 0;
+        for (unsigned int joker = firstJoker; joker <= lastJoker; ++joker)
+        {
+            unsigned int len = nbRackCodes;
+            std::copy(rackCodes, rackCodes + nbRackCodes, codes);
+            if (added)
+                codes[len++] = added;
+            if (joker)
+                codes[len++] = joker;
+            std::sort(codes, codes + len);
+            codes[len] = 0;
+            findAnagrams(codes, len, words);
+        }
+        if (words.empty())
+            continue;
+
+        // With a joker, the same word can be found several times
+        std::sort(words.begin(), words.end(), codesLess);
+        words.erase(std::unique(words.begin(), words.end(), codesEqual),
+                    words.end());
+
+        vector<wdstring> &sols = oWordList[added];
+        BOOST_FOREACH(const dic_code_t *word, words)
+        {
+            wstring letters(iLen + (added ? 1 : 0), L'\0');
+            for (unsigned int i = 0; i < letters.size(); ++i)
+                letters[i] = getHeader().getCharFromCode(word[i]);
+            sols.push_back(convertToDisplay(letters));
+        }
+    }
+}
+
+
 void Dictionary::search7pl1(const wstring &iRack,
                             map<unsigned int, vector<wdstring> > &oWordList,
                             bool joker) const
@@ -184,37 +469,141 @@ void Dictionary::search7pl1(const wstring &iRack,
     if (wordlen < 1)
         return;
 
+    // With several jokers, there are too many combinations to look up,
+    // and the traversal of the DAWG is faster
+    if (hasAnagramIndex() && params.search_letters[0] <= 1)
+    {
+        search7pl1Index(params.search_letters, params.search_letters[0],
+                        wordlen, oWordList);
+        return;
+    }
+
+    /*
+     * Search all the words that can be done with the letters, and with
+     * the letters +1, in a single traversal: the added letter is handled
+     * like an additional joker, remembering which letter it stood for
+     */
+    params.added_code = 0;
+    params.search_len = wordlen;
     const DicEdge *root_edge = getEdgeAt(getRoot());
-    root_edge = getEdgeAt(root_edge->ptr);
+    searchWordByLen(params, 0, getEdgeAt(root_edge->ptr));
 
-    params.results = &oWordList;
+    // The sets of codes are in the order of the dictionary letters
+    map<unsigned int, set<string> >::const_iterator it;
+    for (it = params.results.begin(); it != params.results.end(); ++it)
+    {
+        vector<wdstring> &sols = oWordList[it->first];
+        BOOST_FOREACH(const string &codes, it->second)
+        {
+            wstring word(codes.size(), L'\0');
+            for (unsigned int i = 0; i < codes.size(); ++i)
+                word[i] = getHeader().getCharFromCode(codes[i]);
+            sols.push_back(convertToDisplay(word));
+        }
+    }
+}
 
-    /* search for all the words that can be done with the letters */
-    params.added_code = 0;
-    params.added_display = L"";
-    params.search_len = wordlen - 1;
-    params.search_wordtst[wordlen] = L'\0';
-    searchWordByLen(params, 0, root_edge);
+/****************************************/
+/****************************************/
 
-    /* search for all the words that can be done with the letters +1 */
-    params.search_len = wordlen;
-    params.search_wordtst[wordlen + 1] = L'\0';
-    const wstring &letters = getHeader().getLetters();
-    for (unsigned int i = 0; i < letters.size(); i++)
+struct params_prefixes_t
+{
+    unsigned int minlength;
+    unsigned int maxlength;
+    /// Codes of the suffix
+    string suffix;
+    /// Codes of the current prefix (reversed when walking the GADDAG)
+    string prefix;
+    vector<string> *results;
+};
+
+
+void Dictionary::searchPrefixesGaddag(struct params_prefixes_t &params,
+                                      const dic_elt_t &iElt) const
+{
+    const unsigned int len = params.prefix.size();
+    if (len >= params.minlength)
+    {
+        // The separator ends a word when the whole word has been walked
+        const dic_elt_t sep = getSuccByCode(iElt, DIC_GADDAG_SEPARATOR);
+        if (sep && isEndOfWord(sep))
+        {
+            params.results->push_back(string(params.prefix.rbegin(),
+                                             params.prefix.rend()));
+        }
+    }
+    if (len >= params.maxlength)
+        return;
+
+    // Continue with the preceding letters
+    for (dic_elt_t elt = getSucc(iElt); elt != 0; elt = getNext(elt))
     {
-        unsigned int code = getHeader().getCodeFromChar(letters[i]);
-        params.added_code = code;
-        params.added_display = getHeader().getDisplayStr(code);
-        params.search_letters[code]++;
+        if (getCode(elt) == DIC_GADDAG_SEPARATOR)
+            continue;
+        params.prefix.push_back(getCode(elt));
+        searchPrefixesGaddag(params, elt);
+        params.prefix.erase(len);
+    }
+}
 
-        searchWordByLen(params, 0, root_edge);
 
-        params.search_letters[code]--;
+void Dictionary::searchPrefixesDawg(struct params_prefixes_t &params,
+                                    const dic_elt_t &iElt) const
+{
+    const unsigned int len = params.prefix.size();
+    if (len >= params.minlength)
+    {
+        dic_elt_t elt = iElt;
+        for (unsigned int i = 0; elt != 0 && i < params.suffix.size(); ++i)
+            elt = getSuccByCode(elt, params.suffix[i]);
+        if (elt != 0 && isEndOfWord(elt))
+            params.results->push_back(params.prefix);
+    }
+    if (len >= params.maxlength)
+        return;
+
+    for (dic_elt_t elt = getSucc(iElt); elt != 0; elt = getNext(elt))
+    {
+        params.prefix.push_back(getCode(elt));
+        searchPrefixesDawg(params, elt);
+        params.prefix.erase(len);
+    }
+}
+
+
+void Dictionary::searchPrefixes(const wstring &iSuffix,
+                                unsigned int iMinLen, unsigned int iMaxLen,
+                                vector<string> &oPrefixes) const
+{
+    if (!validateLetters(iSuffix))
+        return;
+
+    struct params_prefixes_t params;
+    params.minlength = iMinLen;
+    params.maxlength = iMaxLen;
+    params.results = &oPrefixes;
+    const wstring suffix = toUpper(iSuffix);
+    for (unsigned int i = 0; i < suffix.size(); ++i)
+        params.suffix.push_back(getHeader().getCodeFromChar(suffix[i]));
+
+    if (hasGaddag())
+    {
+        // Walk the reversed suffix, then the prefixes in reverse order
+        dic_elt_t elt = getGaddagRoot();
+        for (int i = params.suffix.size() - 1; elt != 0 && i >= 0; --i)
+            elt = getSuccByCode(elt, params.suffix[i]);
+        if (elt == 0)
+            return;
+        searchPrefixesGaddag(params, elt);
+        // The prefixes are found in the order of their last letters
+        std::sort(oPrefixes.begin(), oPrefixes.end());
+    }
+    else
+    {
+        searchPrefixesDawg(params, getRoot());
     }
 }
 
-/****************************************/
-/****************************************/
 
 void Dictionary::searchRacc(const wstring &iWord,
                             vector<wdstring> &oWordList,
@@ -235,14 +624,11 @@ void Dictionary::searchRacc(const wstring &iWord,
     displayWord = toUpper(displayWord);
 
     // Try to add a letter at the front
-    const wstring &letters = getHeader().getLetters();
-    for (unsigned int i = 0; i <= letters.size(); i++)
+    vector<string> prefixes;
+    searchPrefixes(iWord, 1, 1, prefixes);
+    BOOST_FOREACH(const string &prefix, prefixes)
     {
-        if (searchWord(letters[i] + iWord))
-        {
-            const wdstring &chr = getHeader().getDisplayStr(getHeader().getCodeFromChar(letters[i]));
-            oWordList.push_back(chr + displayWord);
-        }
+        oWordList.push_back(getHeader().getDisplayStr(prefix[0]) + displayWord);
         if (iMaxResults && oWordList.size() >= iMaxResults)
             return;
     }
@@ -288,30 +674,63 @@ void Dictionary::searchBenj(const wstring &iWord, vector<wdstring> &oWordList,
     // Make it uppercase
     displayWord = toUpper(displayWord);
 
-    const DicEdge *edge0, *edge1, *edge2, *edgetst;
-    edge0 = getEdgeAt(getRoot());
-    edge0 = getEdgeAt(edge0->ptr);
-    do
+    // Add 3 letters at the front
+    vector<string> prefixes;
+    searchPrefixes(iWord, 3, 3, prefixes);
+    BOOST_FOREACH(const string &prefix, prefixes)
     {
-        const wdstring &chr0 = getHeader().getDisplayStr(edge0->chr);
-        edge1 = getEdgeAt(edge0->ptr);
-        do
-        {
-            const wdstring &chr1 = getHeader().getDisplayStr(edge1->chr);
-            edge2 = getEdgeAt(edge1->ptr);
-            do
-            {
-                edgetst = seekEdgePtr(iWord.c_str(), edge2);
-                if (edgetst->term)
-                {
-                    const wdstring &chr2 = getHeader().getDisplayStr(edge2->chr);
-                    oWordList.push_back(chr0 + chr1 + chr2 + displayWord);
-                    if (iMaxResults && oWordList.size() >= iMaxResults)
-                        return;
-                }
-            } while (!(*edge2++).last);
-        } while (!(*edge1++).last);
-    } while (!(*edge0++).last);
+        oWordList.push_back(getHeader().getDisplayStr(prefix[0]) +
+                            getHeader().getDisplayStr(prefix[1]) +
+                            getHeader().getDisplayStr(prefix[2]) +
+                            displayWord);
+        if (iMaxResults && oWordList.size() >= iMaxResults)
+            return;
+    }
+}
+
+/****************************************/
+/****************************************/
+
+void Dictionary::searchEnding(const wstring &iSuffix,
+                              vector<wdstring> &oWordList,
+                              unsigned int iMaxResults) const
+{
+    if (iSuffix == L"" || iSuffix.size() > DIC_WORD_MAX)
+        return;
+
+    // Allocate room for all the results
+    if (iMaxResults)
+        oWordList.reserve(iMaxResults);
+    else
+        oWordList.reserve(DEFAULT_VECT_ALLOC);
+
+    vector<string> words;
+    searchPrefixes(iSuffix, 0, DIC_WORD_MAX - iSuffix.size(), words);
+    if (words.empty())
+        return;
+
+    // The prefixes are sorted, but the words are not necessarily (AIRS
+    // comes before AIRES), so sort the complete words before truncating
+    // the list
+    const wstring suffix = toUpper(iSuffix);
+    string suffixCodes;
+    for (unsigned int i = 0; i < suffix.size(); ++i)
+        suffixCodes.push_back(getHeader().getCodeFromChar(suffix[i]));
+    BOOST_FOREACH(string &word, words)
+    {
+        word += suffixCodes;
+    }
+    std::sort(words.begin(), words.end());
+
+    BOOST_FOREACH(const string &word, words)
+    {
+        wdstring displayWord;
+        for (unsigned int i = 0; i < word.size(); ++i)
+            displayWord += getHeader().getDisplayStr(word[i]);
+        oWordList.push_back(displayWord);
+        if (iMaxResults && oWordList.size() >= iMaxResults)
+            return;
+    }
 }
 
 /****************************************/
@@ -321,88 +740,251 @@ struct params_regexp_t
 {
     unsigned int minlength;
     unsigned int maxlength;
-    Automaton *automaton_field;
+    const Automaton *automaton_field;
+    WordReceiver *receiver;
+    /// Set when the receiver stopped the search
+    bool stopped;
+    /// Codes of the current word
+    string word;
+    /// Display form of the accepted word (reused to avoid allocations)
+    wdstring display;
+    /**
+     * Number of tiles still available for each code, and number of
+     * jokers at index 0 (only used by searchRegExpRack())
+     */
+    char rack[DIC_LETTERS + 1];
 };
 
 
-void Dictionary::searchRegexpRec(const struct params_regexp_t &params,
+void Dictionary::searchRegexpRec(struct params_regexp_t &params,
                                  int state,
-                                 const DicEdge *edgeptr,
-                                 vector<wdstring> &oWordList,
-                                 unsigned int iMaxResults,
-                                 const wdstring &iCurrWord,
-                                 unsigned int iNbChars) const
+                                 const DicEdge *edgeptr) const
 {
-    if (iMaxResults && oWordList.size() >= iMaxResults)
-        return;
-
-    int next_state;
-    /* if we have a valid word we store it */
+    const unsigned int nbChars = params.word.size();
+    /* if we have a valid word we give it to the receiver */
     if (params.automaton_field->accept(state) && edgeptr->term)
     {
-        if (params.minlength <= iNbChars &&
-            params.maxlength >= iNbChars)
+        if (params.minlength <= nbChars &&
+            params.maxlength >= nbChars)
         {
-            oWordList.push_back(iCurrWord);
+            params.display.clear();
+            for (unsigned int i = 0; i < nbChars; ++i)
+                params.display += getHeader().getDisplayStr(params.word[i]);
+            if (!params.receiver->receive(params.display))
+            {
+                params.stopped = true;
+                return;
+            }
         }
     }
+    /* longer words cannot match */
+    if (nbChars >= params.maxlength)
+        return;
+
     /* we now drive the search by exploring the dictionary */
     const DicEdge *current = getEdgeAt(edgeptr->ptr);
     do
     {
         /* the current letter is current->chr */
-        next_state = params.automaton_field->getNextState(state, current->chr);
+        const int next_state =
+            params.automaton_field->getNextState(state, current->chr);
         /* 1: the letter appears in the automaton as is */
         if (next_state)
         {
-            searchRegexpRec(params, next_state, current, oWordList, iMaxResults,
-                            iCurrWord + getHeader().getDisplayStr(current->chr), iNbChars + 1);
+            params.word.push_back(current->chr);
+            searchRegexpRec(params, next_state, current);
+            params.word.erase(nbChars);
+            if (params.stopped)
+                return;
         }
     } while (!(*current++).last);
 }
 
 
-/**
- * Initialize the lists of letters with pre-defined lists
- * 0: all tiles
- * 1: vowels
- * 2: consonants
- * 3: user defined 1
- * 4: user defined 2
- * x: lists used during parsing
- */
-static void initLetterLists(const Dictionary &iDic,
-                            searchRegExpLists &iList)
-{
-    memset(&iList, 0, sizeof(iList));
-    // Prepare the space for 5 items
-    iList.symbl.assign(5, 0);
-    iList.letters.assign(5, vector<bool>(DIC_LETTERS + 1, false));
-
-    iList.symbl[0] = RE_ALL_MATCH; // All letters
-    iList.symbl[1] = RE_VOWL_MATCH; // Vowels
-    iList.symbl[2] = RE_CONS_MATCH; // Consonants
-    iList.letters[0][0] = false;
-    iList.letters[1][0] = false;
-    iList.letters[2][0] = false;
-    const wstring &allLetters = iDic.getHeader().getLetters();
-    for (size_t i = 1; i <= allLetters.size(); ++i)
-    {
-        iList.letters[0][i] = true;
-        iList.letters[1][i] = iDic.getHeader().isVowel(i);
-        iList.letters[2][i] = iDic.getHeader().isConsonant(i);
-    }
-
-    iList.symbl[3] = RE_USR1_MATCH; // User defined list 1
-    iList.symbl[4] = RE_USR2_MATCH; // User defined list 2
+void Dictionary::searchRegexpRackRec(struct params_regexp_t &params,
+                                     int state,
+                                     const DicEdge *edgeptr) const
+{
+    const unsigned int nbChars = params.word.size();
+    /* if we have a valid word we give it to the receiver */
+    if (params.automaton_field->accept(state) && edgeptr->term &&
+        params.minlength <= nbChars)
+    {
+        params.display.clear();
+        for (unsigned int i = 0; i < nbChars; ++i)
+            params.display += getHeader().getDisplayStr(params.word[i]);
+        if (!params.receiver->receive(params.display))
+        {
+            params.stopped = true;
+            return;
+        }
+    }
+    /* longer words cannot match, or cannot be made with the rack */
+    if (nbChars >= params.maxlength)
+        return;
+
+    const DicEdge *current = getEdgeAt(edgeptr->ptr);
+    do
+    {
+        const int next_state =
+            params.automaton_field->getNextState(state, current->chr);
+        if (next_state == 0)
+            continue;
+        /* the letter is taken from the rack if possible, so that the
+           jokers are kept for the other letters */
+        const unsigned int tile =
+            params.rack[(unsigned int)current->chr] ? current->chr : 0;
+        if (params.rack[tile] == 0)
+            continue;
+        params.rack[tile]--;
+        params.word.push_back(current->chr);
+        searchRegexpRackRec(params, next_state, current);
+        params.word.erase(nbChars);
+        params.rack[tile]++;
+        if (params.stopped)
+            return;
+    } while (!(*current++).last);
 }
 
 
+/// Receiver filling a vector with at most a given number of words
+class WordListReceiver : public WordReceiver
+{
+public:
+    WordListReceiver(vector<wdstring> &oWordList, unsigned int iMaxResults)
+        : m_wordList(oWordList), m_maxResults(iMaxResults), m_nbWords(0) {}
+
+    virtual bool receive(const wdstring &iWord)
+    {
+        m_wordList.push_back(iWord);
+        ++m_nbWords;
+        return !m_maxResults || m_nbWords < m_maxResults;
+    }
+
+    unsigned int getNbWords() const { return m_nbWords; }
+
+private:
+    vector<wdstring> &m_wordList;
+    unsigned int m_maxResults;
+    unsigned int m_nbWords;
+};
+
+
+#if HAVE_BOOST_THREAD
+/// Part of the dictionary searched by the parallel version of searchRegExp()
+struct regexp_task_t
+{
+    /// Codes of the letters leading to this part of the dictionary
+    string prefix;
+    /// State of the automaton after the prefix
+    unsigned int state;
+    /// Edge of the last letter of the prefix
+    const DicEdge *edge;
+    /// If false, only the prefix itself is checked (and not its extensions)
+    bool subtree;
+    /// Set when the task has been executed
+    bool finished;
+    /// Matching words found in this part, in dictionary order
+    vector<wdstring> words;
+};
+
+
+/// Tasks shared by the threads of the parallel version of searchRegExp()
+struct regexp_tasks_t
+{
+    const Automaton *automaton;
+    unsigned int minlength;
+    unsigned int maxlength;
+    /// Number of words needed (0 means no limit)
+    unsigned int maxResults;
+    /// Tasks, in dictionary order
+    vector<regexp_task_t> tasks;
+    /// Index of the next task to execute
+    unsigned int nextTask;
+    /// Number of tasks executed, without gap from the first one
+    unsigned int nbFinished;
+    /// Number of words found in these tasks
+    unsigned int nbFinishedWords;
+    /// Number of tasks needed to find maxResults words
+    unsigned int nbNeeded;
+    boost::mutex mutex;
+};
+
+
+/// Functor running Dictionary::searchRegexpTasks() in a thread
+class RegexpSearcher
+{
+public:
+    RegexpSearcher(const Dictionary &iDic, regexp_tasks_t &ioTasks)
+        : m_dic(iDic), m_tasks(ioTasks)
+    {
+    }
+
+    void operator()() const
+    {
+        m_dic.searchRegexpTasks(m_tasks);
+    }
+
+private:
+    const Dictionary &m_dic;
+    regexp_tasks_t &m_tasks;
+};
+
+
+void Dictionary::searchRegexpTasks(regexp_tasks_t &ioTasks) const
+{
+    struct params_regexp_t params;
+    params.minlength = ioTasks.minlength;
+    params.automaton_field = ioTasks.automaton;
+    params.word.reserve(DIC_WORD_MAX);
+
+    while (true)
+    {
+        unsigned int index;
+        {
+            boost::mutex::scoped_lock lock(ioTasks.mutex);
+            // The following tasks cannot contain needed words
+            if (ioTasks.nextTask >= ioTasks.nbNeeded)
+                return;
+            index = ioTasks.nextTask++;
+        }
+
+        regexp_task_t &task = ioTasks.tasks[index];
+        WordListReceiver receiver(task.words, ioTasks.maxResults);
+        params.receiver = &receiver;
+        params.stopped = false;
+        params.word = task.prefix;
+        // Without subtree, the recursion stops right after the prefix
+        params.maxlength = task.subtree ? ioTasks.maxlength :
+            min<unsigned int>(ioTasks.maxlength, task.prefix.size());
+        searchRegexpRec(params, task.state, task.edge);
+
+        boost::mutex::scoped_lock lock(ioTasks.mutex);
+        task.finished = true;
+        while (ioTasks.nbFinished < ioTasks.tasks.size() &&
+               ioTasks.tasks[ioTasks.nbFinished].finished)
+        {
+            ioTasks.nbFinishedWords +=
+                ioTasks.tasks[ioTasks.nbFinished].words.size();
+            ++ioTasks.nbFinished;
+            if (ioTasks.maxResults &&
+                ioTasks.nbFinishedWords >= ioTasks.maxResults &&
+                ioTasks.nbNeeded > ioTasks.nbFinished)
+            {
+                ioTasks.nbNeeded = ioTasks.nbFinished;
+            }
+        }
+    }
+}
+#endif
+
+
 bool Dictionary::searchRegExp(const wstring &iRegexp,
                               vector<wdstring> &oWordList,
                               unsigned int iMinLength,
                               unsigned int iMaxLength,
-                              unsigned int iMaxResults) const
+                              unsigned int iMaxResults,
+                              unsigned int iNbThreads) const
 {
     if (iRegexp == L"")
         return true;
@@ -414,52 +996,273 @@ bool Dictionary::searchRegExp(const wstring &iRegexp,
     else
         oWordList.reserve(DEFAULT_VECT_ALLOC);
 
-    // Parsing
-    Node *root = NULL;
-    searchRegExpLists llist;
-    // Initialize the lists of letters
-    initLetterLists(*this, llist);
-    bool parsingOk = parseRegexp(*this, (iRegexp + L"#").c_str(), &root, llist);
+#if HAVE_BOOST_THREAD
+    if (iNbThreads == 0)
+        iNbThreads = boost::thread::hardware_concurrency();
+    if (iNbThreads > 1)
+    {
+        regexp_tasks_t tasks;
+        const boost::shared_ptr<const Automaton> a =
+            m_automatonCache->getAutomaton(iRegexp);
+        tasks.automaton = a.get();
+        tasks.minlength = iMinLength;
+        tasks.maxlength = iMaxLength;
+        // Look for one more result, to know if the limit was reached
+        tasks.maxResults = iMaxResults ? iMaxResults + 1 : 0;
 
-    if (!parsingOk)
+        // Split the dictionary in parts, following the edges from the
+        // root as deep as needed to have several parts for each thread
+        // (the first letters of the words are not evenly distributed)
+        regexp_task_t rootTask;
+        rootTask.state = a->getInitId();
+        rootTask.edge = getEdgeAt(getRoot());
+        rootTask.subtree = true;
+        rootTask.finished = false;
+        tasks.tasks.push_back(rootTask);
+        for (unsigned int depth = 0;
+             depth < kMaxRegexpSplitDepth && depth < iMaxLength &&
+             tasks.tasks.size() < kRegexpTasksPerThread * iNbThreads;
+             ++depth)
+        {
+            vector<regexp_task_t> newTasks;
+            BOOST_FOREACH(const regexp_task_t &task, tasks.tasks)
+            {
+                if (!task.subtree)
+                {
+                    newTasks.push_back(task);
+                    continue;
+                }
+                // The prefix itself comes before its extensions
+                if (depth > 0)
+                {
+                    newTasks.push_back(task);
+                    newTasks.back().subtree = false;
+                }
+                const DicEdge *current = getEdgeAt(task.edge->ptr);
+                do
+                {
+                    const unsigned int next_state =
+                        a->getNextState(task.state, current->chr);
+                    if (next_state)
+                    {
+                        regexp_task_t child = task;
+                        child.prefix.push_back(current->chr);
+                        child.state = next_state;
+                        child.edge = current;
+                        newTasks.push_back(child);
+                    }
+                } while (!(*current++).last);
+            }
+            tasks.tasks.swap(newTasks);
+        }
+
+        tasks.nextTask = 0;
+        tasks.nbFinished = 0;
+        tasks.nbFinishedWords = 0;
+        tasks.nbNeeded = tasks.tasks.size();
+        boost::thread_group threads;
+        for (unsigned int i = 1; i < iNbThreads; ++i)
+            threads.create_thread(RegexpSearcher(*this, tasks));
+        // The current thread works too
+        searchRegexpTasks(tasks);
+        threads.join_all();
+
+        // Merge the results, in dictionary order
+        const unsigned int initialSize = oWordList.size();
+        for (unsigned int i = 0; i < tasks.nbNeeded; ++i)
+        {
+            const vector<wdstring> &words = tasks.tasks[i].words;
+            oWordList.insert(oWordList.end(), words.begin(), words.end());
+        }
+
+        // Check whether the maximum number of results was reached
+        if (iMaxResults && oWordList.size() - initialSize > iMaxResults)
+        {
+            oWordList.resize(initialSize + iMaxResults);
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // Look for one more result, to know if the limit was reached
+    WordListReceiver receiver(oWordList, iMaxResults ? iMaxResults + 1 : 0);
+    searchRegExp(iRegexp, receiver, iMinLength, iMaxLength);
+
+    // Check whether the maximum number of results was reached
+    if (iMaxResults && receiver.getNbWords() > iMaxResults)
     {
-        delete root;
-        throw InvalidRegexpException(lfw(iRegexp));
+        oWordList.pop_back();
+        return false;
     }
+    else
+        return true;
+}
+
+
+bool Dictionary::searchRegExp(const wstring &iRegexp,
+                              WordReceiver &ioReceiver,
+                              unsigned int iMinLength,
+                              unsigned int iMaxLength) const
+{
+    if (iRegexp == L"")
+        return true;
+
+    const boost::shared_ptr<const Automaton> a =
+        m_automatonCache->getAutomaton(iRegexp);
 
-    int ptl[REGEXP_MAX+1];
-    uint64_t PS[REGEXP_MAX+1];
+    struct params_regexp_t params;
+    params.minlength = iMinLength;
+    params.maxlength = iMaxLength;
+    params.automaton_field = a.get();
+    params.receiver = &ioReceiver;
+    params.stopped = false;
+    params.word.reserve(DIC_WORD_MAX);
+    searchRegexpRec(params, a->getInitId(), getEdgeAt(getRoot()));
 
-    for (int i = 0; i < REGEXP_MAX; i++)
+    return !params.stopped;
+}
+
+
+/// Parameters of countRegexpRec()
+struct params_count_t
+{
+    unsigned int minlength;
+    /// Maximum length of the words (0 means no limit)
+    unsigned int maxlength;
+    const Automaton *automaton;
+    /**
+     * States from which all the words are accepted (only computed if the
+     * dictionary has word counts)
+     */
+    vector<bool> universal;
+};
+
+
+unsigned int Dictionary::countRegexpRec(const struct params_count_t &params,
+                                        unsigned int state,
+                                        const DicEdge *edgeptr,
+                                        unsigned int depth) const
+{
+    // Without length constraint anymore, all the words below the edge
+    // are accepted from a universal state
+    if (depth >= params.minlength && params.maxlength == 0 &&
+        !params.universal.empty() && params.universal[state])
+    {
+        return getWordsThrough(edgeptr - getEdgeAt(0));
+    }
+
+    unsigned int count = 0;
+    if (params.automaton->accept(state) && edgeptr->term &&
+        depth >= params.minlength)
+    {
+        count = 1;
+    }
+    if (edgeptr->ptr == 0 || (params.maxlength && depth == params.maxlength))
+        return count;
+
+    unsigned int below = 0;
+    const DicEdge *current = getEdgeAt(edgeptr->ptr);
+    do
+    {
+        const unsigned int next_state =
+            params.automaton->getNextState(state, current->chr);
+        if (next_state)
+            below += countRegexpRec(params, next_state, current, depth + 1);
+    } while (!(*current++).last);
+
+    return count + below;
+}
+
+
+unsigned int Dictionary::countRegExp(const wstring &iRegexp,
+                                     unsigned int iMinLength,
+                                     unsigned int iMaxLength) const
+{
+    if (iRegexp == L"")
+        return 0;
+
+    const boost::shared_ptr<const Automaton> a =
+        m_automatonCache->getAutomaton(iRegexp);
+
+    struct params_count_t params;
+    params.minlength = iMinLength;
+    params.maxlength = iMaxLength;
+    params.automaton = a.get();
+    if (hasWordCounts())
     {
-        PS[i] = 0;
-        ptl[i] = 0;
+        // Greatest set of accepting states whose successors for all the
+        // letters are in the set
+        const unsigned int nbStates = a->getNbStates();
+        const unsigned int maxCode = getHeader().getMaxCode();
+        params.universal.assign(nbStates + 1, false);
+        for (unsigned int s = 1; s <= nbStates; ++s)
+            params.universal[s] = a->accept(s);
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (unsigned int s = 1; s <= nbStates; ++s)
+            {
+                if (!params.universal[s])
+                    continue;
+                for (unsigned int code = 1; code <= maxCode; ++code)
+                {
+                    if (!params.universal[a->getNextState(s, code)])
+                    {
+                        params.universal[s] = false;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
     }
 
-    int n = 1;
-    int p = 1;
-    root->traverse(p, n, ptl);
-    PS [0] = p - 1;
-    ptl[0] = p - 1;
+    return countRegexpRec(params, a->getInitId(), getEdgeAt(getRoot()), 0);
+}
+
 
-    root->nextPos(PS);
+bool Dictionary::searchRegExpRack(const wstring &iRegexp,
+                                  const wstring &iRack,
+                                  vector<wdstring> &oWordList,
+                                  unsigned int iMinLength,
+                                  unsigned int iMaxLength,
+                                  unsigned int iMaxResults) const
+{
+    if (iRegexp == L"")
+        return true;
 
-    Automaton *a = new Automaton(root->getFirstPos(), ptl, PS, llist);
-    if (a)
+    struct params_regexp_t params;
+    memset(params.rack, 0, sizeof(params.rack));
+    unsigned int nbTiles = 0;
+    for (const wchar_t* r = iRack.c_str(); *r; r++)
     {
-        struct params_regexp_t params;
-        params.minlength = iMinLength;
-        params.maxlength = iMaxLength;
-        params.automaton_field = a;
-        searchRegexpRec(params, a->getInitId(),
-                        getEdgeAt(getRoot()), oWordList,
-                        iMaxResults ? iMaxResults + 1 : 0);
-        delete a;
+        if (iswalpha(*r))
+            params.rack[getHeader().getCodeFromChar(towupper(*r))]++;
+        else if (*r == L'?')
+            params.rack[0]++;
+        else
+            continue;
+        nbTiles++;
     }
-    delete root;
+
+    const boost::shared_ptr<const Automaton> a =
+        m_automatonCache->getAutomaton(iRegexp);
+
+    // Look for one more result, to know if the limit was reached
+    WordListReceiver receiver(oWordList, iMaxResults ? iMaxResults + 1 : 0);
+
+    params.minlength = iMinLength;
+    params.maxlength = min(iMaxLength, nbTiles);
+    params.automaton_field = a.get();
+    params.receiver = &receiver;
+    params.stopped = false;
+    params.word.reserve(DIC_WORD_MAX);
+    searchRegexpRackRec(params, a->getInitId(), getEdgeAt(getRoot()));
 
     // Check whether the maximum number of results was reached
-    if (iMaxResults && oWordList.size() > iMaxResults)
+    if (iMaxResults && receiver.getNbWords() > iMaxResults)
     {
         oWordList.pop_back();
         return false;
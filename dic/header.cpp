@@ -20,7 +20,8 @@
 
 #include "config.h"
 
-#include <cstring> // for strcpy
+#include <cstring> // for strcpy and memset
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -48,6 +49,7 @@
 #endif
 
 #include "header.h"
+#include "dic_internals.h"
 #include "encoding.h"
 #include "dic_exception.h"
 
@@ -62,7 +64,10 @@ INIT_LOGGER(dic, Header);
 // Nothing to do on big-endian machines
 #   define ntohll(x) (x)
 #   define htonll(x) (x)
+static const bool kHostBigEndian = true;
 #else
+static const bool kHostBigEndian = false;
+
 static inline uint64_t htonll(uint64_t host64)
 {
     return (((uint64_t)htonl((host64 << 32) >> 32)) << 32) | htonl(host64 >> 32);
@@ -109,6 +114,14 @@ struct Dict_header_old
 #define _MAX_LETTERS_SIZE_ 80
 #define _MAX_DISPLAY_INPUT_SIZE_ 112
 
+/**
+ * Value written without conversion in the version 3 header, allowing to
+ * detect the byte order used for the edges
+ */
+#define _BYTE_ORDER_MARK_ 0x01020304
+/// Alignment of the edges in version 3 (suitable for mmap() on most systems)
+#define _EDGES_ALIGNMENT_ 4096
+
 /** Extension of the old format (used in version 1) */
 struct Dict_header_ext
 {
@@ -186,10 +199,47 @@ struct Dict_header_ext_2
     // --- we have a multiple of 64 bytes here
 };
 
+/** Extension used in version 3, for native byte order edges */
+struct Dict_header_ext_3
+{
+    Dict_header_ext_3()
+    {
+        // Make sure we won't write uninitialized bytes
+        memset(this, 0, sizeof(*this));
+    }
+
+    // _BYTE_ORDER_MARK_, in the byte order of the edges
+    uint32_t byteOrderMark;
+    // Position of the first edge in the file (big endian, like the
+    // rest of the header). The space up to this offset is filled with 0.
+    uint32_t edgesOffset;
+
+    // --- we have a multiple of 64 bits here
+
+    // Root of the GADDAG, for dictionaries of type GADDAG
+    uint32_t gaddagRoot;
+    // Size in bytes of the child masks following the word counts
+    // (0 if none)
+    uint32_t childMasksSize;
+
+    // --- we have a multiple of 64 bits here
+
+    // Size in bytes of the anagram index following the edges (0 if none)
+    uint32_t anagramSize;
+    // Size in bytes of the word counts following the anagram index
+    // (0 if none)
+    uint32_t wordCountsSize;
+
+    // --- we have a multiple of 64 bits here
+};
+
 
 Header::Header(istream &iStream)
-    : m_root(0), m_nbWords(0), m_nodesUsed(0), m_edgesUsed(0),
-      m_nodesSaved(0), m_edgesSaved(0), m_type(kDAWG)
+    : m_root(0), m_gaddagRoot(0), m_anagramSize(0), m_wordCountsSize(0),
+      m_childMasksSize(0),
+      m_nbWords(0), m_nodesUsed(0), m_edgesUsed(0),
+      m_nodesSaved(0), m_edgesSaved(0), m_type(kDAWG),
+      m_bigEndianEdges(true), m_edgesOffset(0)
 {
     // Simply delegate to the read() method
     // The code is not moved here because I find it more natural to have a
@@ -201,8 +251,23 @@ Header::Header(istream &iStream)
 
 Header::Header(const DictHeaderInfo &iInfo)
 {
-    // Use the latest serialization format
-    m_version = 2;
+    // Use the latest serialization format, unless the native byte order,
+    // a GADDAG, an anagram index, word counts or child masks are requested
+    // (older Eliot versions cannot read them)
+    if (iInfo.nativeEdges || !iInfo.dawg || iInfo.anagramSize ||
+        iInfo.wordCountsSize || iInfo.childMasksSize)
+    {
+        m_version = 3;
+        m_bigEndianEdges = iInfo.nativeEdges ? kHostBigEndian : true;
+        m_edgesOffset = _EDGES_ALIGNMENT_;
+    }
+    else
+    {
+        m_version = 2;
+        m_bigEndianEdges = true;
+        m_edgesOffset = sizeof(Dict_header_old) +
+            sizeof(Dict_header_ext) + sizeof(Dict_header_ext_2);
+    }
 
     // Sanity checks
     if (iInfo.letters.size() > _MAX_LETTERS_NB_)
@@ -236,6 +301,10 @@ Header::Header(const DictHeaderInfo &iInfo)
     m_compressDate = time(NULL);
     m_userHost = wfl(ELIOT_COMPILE_BY + string("@") + ELIOT_COMPILE_HOST);
     m_root = iInfo.root;
+    m_gaddagRoot = iInfo.dawg ? 0 : iInfo.gaddagRoot;
+    m_anagramSize = iInfo.anagramSize;
+    m_wordCountsSize = iInfo.wordCountsSize;
+    m_childMasksSize = iInfo.childMasksSize;
     m_nbWords = iInfo.nwords;
     m_nodesUsed = iInfo.nodesused;
     m_edgesUsed = iInfo.edgesused;
@@ -257,11 +326,24 @@ Header::Header(const DictHeaderInfo &iInfo)
 void Header::buildCaches()
 {
     // Build the char --> code mapping
+    map<wchar_t, unsigned int> codeFromChar;
     for (unsigned int i = 0; i < m_letters.size(); ++i)
     {
         // We don't differentiate uppercase and lowercase letters
-        m_mapCodeFromChar[towlower(m_letters[i])] = i + 1;
-        m_mapCodeFromChar[towupper(m_letters[i])] = i + 1;
+        codeFromChar[towlower(m_letters[i])] = i + 1;
+        codeFromChar[towupper(m_letters[i])] = i + 1;
+    }
+    // Split it in a table for the most common characters, and a sorted
+    // vector for the others
+    memset(m_codeTable, 0, sizeof(m_codeTable));
+    m_otherCodes.clear();
+    map<wchar_t, unsigned int>::const_iterator it;
+    for (it = codeFromChar.begin(); it != codeFromChar.end(); ++it)
+    {
+        if ((unsigned int)it->first < kCodeTableSize)
+            m_codeTable[it->first] = it->second;
+        else
+            m_otherCodes.push_back(make_pair(it->first, (uint8_t)it->second));
     }
 
     // Build the display strings cache
@@ -306,6 +388,12 @@ void Header::buildCaches()
 }
 
 
+bool Header::hasHostOrderEdges() const
+{
+    return m_bigEndianEdges == kHostBigEndian;
+}
+
+
 bool Header::isMultiCharPart(wchar_t iChar) const
 {
     return m_multiCharInputChars.find(towupper(iChar)) != wstring::npos;
@@ -327,15 +415,25 @@ wchar_t Header::getCharFromCode(unsigned int iCode) const
 
 unsigned int Header::getCodeFromChar(wchar_t iChar) const
 {
-    map<wchar_t, unsigned int>::const_iterator pair =
-        m_mapCodeFromChar.find(iChar);
-    if (pair == m_mapCodeFromChar.end())
+    const unsigned int code = findCodeFromChar(iChar);
+    if (code == 0)
     {
         format fmt(_("Header::getCodeFromChar: No code for letter '%1%' (val=%2%)"));
         fmt % lfw(iChar) % (unsigned) iChar;
         throw DicException(fmt.str());
     }
-    return pair->second;
+    return code;
+}
+
+
+unsigned int Header::findOtherCode(wchar_t iChar) const
+{
+    vector<pair<wchar_t, uint8_t> >::const_iterator it =
+        lower_bound(m_otherCodes.begin(), m_otherCodes.end(),
+                    make_pair(iChar, (uint8_t)0));
+    if (it == m_otherCodes.end() || it->first != iChar)
+        return 0;
+    return it->second;
 }
 
 
@@ -483,6 +581,46 @@ void Header::read(istream &iStream)
         // Parse this string and structure the data
         readDisplayAndInput(serialized);
     }
+
+    if (m_version >= 3)
+    {
+        Dict_header_ext_3 aHeaderExt3;
+        iStream.read((char*)&aHeaderExt3, sizeof(Dict_header_ext_3));
+        if (iStream.gcount() != sizeof(Dict_header_ext_3))
+            throw DicException("Header::read: expected to read more bytes (ext3)");
+
+        // The byte order mark is not converted on purpose
+        if (aHeaderExt3.byteOrderMark == _BYTE_ORDER_MARK_)
+            m_bigEndianEdges = kHostBigEndian;
+        else if (aHeaderExt3.byteOrderMark == swapBytes(_BYTE_ORDER_MARK_))
+            m_bigEndianEdges = !kHostBigEndian;
+        else
+            throw DicException("Header::read: invalid byte order mark");
+
+        m_edgesOffset = ntohl(aHeaderExt3.edgesOffset);
+        m_gaddagRoot = ntohl(aHeaderExt3.gaddagRoot);
+        m_anagramSize = ntohl(aHeaderExt3.anagramSize);
+        m_wordCountsSize = ntohl(aHeaderExt3.wordCountsSize);
+        m_childMasksSize = ntohl(aHeaderExt3.childMasksSize);
+        if (m_type == kGADDAG && m_gaddagRoot == 0)
+            throw DicException("Header::read: missing GADDAG root");
+        if (m_edgesOffset < (uint32_t)iStream.tellg())
+            throw DicException("Header::read: inconsistent edges offset");
+
+        // Skip the padding
+        iStream.seekg(m_edgesOffset);
+        if (!iStream.good())
+            throw DicException("Header::read: expected to read more bytes (padding)");
+    }
+    else
+    {
+        // Older formats cannot contain a GADDAG
+        if (m_type == kGADDAG)
+            throw DicException("Header::read: GADDAG without root");
+        // The edges follow the header, in network byte order
+        m_bigEndianEdges = true;
+        m_edgesOffset = iStream.tellg();
+    }
 }
 
 
@@ -569,6 +707,30 @@ void Header::write(ostream &oStream) const
     oStream.write((char*)&aHeaderExt2, sizeof(Dict_header_ext_2));
     if (!oStream.good())
         throw DicException("Header::write: error when writing to file (ext2)");
+
+    if (m_version >= 3)
+    {
+        Dict_header_ext_3 aHeaderExt3;
+        // The mark is written in the byte order of the edges
+        if (hasHostOrderEdges())
+            aHeaderExt3.byteOrderMark = _BYTE_ORDER_MARK_;
+        else
+            aHeaderExt3.byteOrderMark = swapBytes(_BYTE_ORDER_MARK_);
+        aHeaderExt3.edgesOffset = htonl(m_edgesOffset);
+        aHeaderExt3.gaddagRoot = htonl(m_gaddagRoot);
+        aHeaderExt3.anagramSize = htonl(m_anagramSize);
+        aHeaderExt3.wordCountsSize = htonl(m_wordCountsSize);
+        aHeaderExt3.childMasksSize = htonl(m_childMasksSize);
+        oStream.write((char*)&aHeaderExt3, sizeof(Dict_header_ext_3));
+
+        // Pad with zeros until the beginning of the edges
+        const streamoff padding = m_edgesOffset -
+            (sizeof(Dict_header_old) + sizeof(Dict_header_ext) +
+             sizeof(Dict_header_ext_2) + sizeof(Dict_header_ext_3));
+        oStream.write(string(padding, '\0').data(), padding);
+        if (!oStream.good())
+            throw DicException("Header::write: error when writing to file (ext3)");
+    }
 }
 
 
@@ -656,10 +818,17 @@ void Header::print(ostream &out) const
     out << fmt(_("Letters: %1%")) % lfw(m_letters) << endl;
     out << fmt(_("Number of letters: %1%")) % m_letters.size() << endl;
     out << fmt(_("Number of words: %1%")) % m_nbWords << endl;
-    long unsigned int size = sizeof(Dict_header_old) +
-        sizeof(Dict_header_ext) + sizeof(Dict_header_ext_2);
-    out << fmt(_("Header size: %1% bytes")) % size << endl;
+    out << fmt(_("Header size: %1% bytes")) % m_edgesOffset << endl;
+    out << fmt(_("Edges byte order: %1%")) % (m_bigEndianEdges ? "big-endian" : "little-endian") << endl;
     out << fmt(_("Root: %1% (edge)")) % m_root << endl;
+    if (m_type == kGADDAG)
+        out << fmt(_("GADDAG root: %1% (edge)")) % m_gaddagRoot << endl;
+    if (m_anagramSize)
+        out << fmt(_("Anagram index: %1% bytes")) % m_anagramSize << endl;
+    if (m_wordCountsSize)
+        out << fmt(_("Word counts: %1% bytes")) % m_wordCountsSize << endl;
+    if (m_childMasksSize)
+        out << fmt(_("Child masks: %1% bytes")) % m_childMasksSize << endl;
     out << fmt(_("Nodes: %1% used + %2% saved")) % m_nodesUsed % m_nodesSaved << endl;
     out << fmt(_("Edges: %1% used + %2% saved")) % m_edgesUsed % m_edgesSaved << endl;
 #undef fmt
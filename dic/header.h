@@ -44,12 +44,22 @@ typedef wstring wistring;
 struct DictHeaderInfo
 {
     uint32_t root;
+    /// Root of the GADDAG (only used when dawg is false)
+    uint32_t gaddagRoot;
+    /// Size in bytes of the anagram index (0 if there is none)
+    uint32_t anagramSize;
+    /// Size in bytes of the word counts (0 if there are none)
+    uint32_t wordCountsSize;
+    /// Size in bytes of the child masks (0 if there are none)
+    uint32_t childMasksSize;
     uint32_t nwords;
     uint32_t edgesused;
     uint32_t nodesused;
     uint32_t nodessaved;
     uint32_t edgessaved;
     bool dawg;
+    /// Store the edges in the byte order of the current machine
+    bool nativeEdges;
     wstring dicName;
     wstring letters;
     vector<uint8_t> points;
@@ -75,6 +85,20 @@ struct DictHeaderInfo
  * write the latest version of the header into a given file.
  * When using the constructor taking an input stream, all the header versions
  * are supported.
+ *
+ * Version 3 is only written when native edges, a GADDAG, an anagram
+ * index or word counts are requested.
+ * The edges start at a page-aligned offset, and they may be stored in the
+ * byte order of the machine which compiled the dictionary (as indicated by
+ * a byte order mark). Older versions always store the edges in big-endian
+ * order, right after the header.
+ *
+ * A dictionary of type kGADDAG contains both a DAWG (starting at getRoot())
+ * and a GADDAG (starting at getGaddagRoot()), sharing the same edges array.
+ *
+ * Version 3 dictionaries can also contain an anagram index, stored right
+ * after the edges (see Dictionary::search7pl1()), and the word counts of
+ * the edges, stored after the anagram index (see Dictionary::getWordId()).
  */
 class Header
 {
@@ -106,11 +130,19 @@ public:
     /// Getters
     //@{
     unsigned int getRoot()         const { return m_root; }
+    unsigned int getGaddagRoot()   const { return m_gaddagRoot; }
     unsigned int getNbWords()      const { return m_nbWords; }
     unsigned int getNbNodesUsed()  const { return m_nodesUsed; }
     unsigned int getNbEdgesUsed()  const { return m_edgesUsed; }
     unsigned int getNbNodesSaved() const { return m_nodesSaved; }
     unsigned int getNbEdgesSaved() const { return m_edgesSaved; }
+    unsigned int getEdgesOffset()  const { return m_edgesOffset; }
+    unsigned int getAnagramOffset() const { return m_edgesOffset + (m_edgesUsed + 1) * 4; }
+    unsigned int getAnagramSize()  const { return m_anagramSize; }
+    unsigned int getWordCountsOffset() const { return getAnagramOffset() + m_anagramSize; }
+    unsigned int getWordCountsSize() const { return m_wordCountsSize; }
+    unsigned int getChildMasksOffset() const { return getWordCountsOffset() + m_wordCountsSize; }
+    unsigned int getChildMasksSize() const { return m_childMasksSize; }
     wstring      getName()         const { return m_dicName; }
     DictType     getType()         const { return m_type; }
     wstring      getLetters()      const { return m_letters; }
@@ -125,6 +157,12 @@ public:
 
     const map<wchar_t, vector<wstring> > & getDisplayInputData() const { return m_displayAndInputData; }
 
+    /**
+     * Return true if the edges following the header are stored in the
+     * byte order of the current machine (i.e. they can be used as is)
+     */
+    bool hasHostOrderEdges() const;
+
     /**
      * Return true if the given char is part of a multi-char input string, false otherwise
      */
@@ -137,9 +175,22 @@ public:
 
     /**
      * Return the code corresponding to the given letter
+     * @exception: Throw a DicException if the letter has no code
      */
     unsigned int getCodeFromChar(wchar_t iChar) const;
 
+    /**
+     * Return the code corresponding to the given letter, or 0 if there is
+     * none. Contrary to getCodeFromChar(), no exception is thrown, so this
+     * is the method to use to check many letters (e.g. in a search).
+     */
+    unsigned int findCodeFromChar(wchar_t iChar) const
+    {
+        if ((unsigned int)iChar < kCodeTableSize)
+            return m_codeTable[iChar];
+        return findOtherCode(iChar);
+    }
+
     /**
      * Return the display string corresponding to the given code
      */
@@ -170,6 +221,10 @@ private:
     time_t m_compressDate;
 
     uint32_t m_root;
+    uint32_t m_gaddagRoot;
+    uint32_t m_anagramSize;
+    uint32_t m_wordCountsSize;
+    uint32_t m_childMasksSize;
     uint32_t m_nbWords;
     uint32_t m_nodesUsed;
     uint32_t m_edgesUsed;
@@ -179,6 +234,12 @@ private:
     /// Specify whether the dictionary is a DAWG or a GADDAG
     DictType m_type;
 
+    /// True if the edges are stored in big-endian order
+    bool m_bigEndianEdges;
+
+    /// Position of the first edge in the file
+    uint32_t m_edgesOffset;
+
     /// Dictionary name (e.g.: ODS 5.0)
     wstring m_dicName;
 
@@ -206,8 +267,18 @@ private:
     /// Additional display and input strings for some letters
     map<wchar_t, vector<wstring> > m_displayAndInputData;
 
-    /// Cache for the char --> code associations
-    map<wchar_t, unsigned int> m_mapCodeFromChar;
+    /**
+     * Number of characters whose code is given directly by m_codeTable:
+     * Latin-1 and the Latin extensions, which contain the letters of most
+     * supported languages
+     */
+    static const unsigned int kCodeTableSize = 0x250;
+
+    /// Code of each character lower than kCodeTableSize (0 if none)
+    uint8_t m_codeTable[kCodeTableSize];
+
+    /// Codes of the other characters, sorted by character
+    vector<pair<wchar_t, uint8_t> > m_otherCodes;
 
     /// Cache for the display string of each code
     vector<wdstring> m_displayCache;
@@ -222,6 +293,9 @@ private:
     /** Build various caches */
     void buildCaches();
 
+    /// Helper for findCodeFromChar(), for the characters outside m_codeTable
+    unsigned int findOtherCode(wchar_t iChar) const;
+
     /**
      * Fill the m_displayAndInputData field from the serialized data
      * of the given string
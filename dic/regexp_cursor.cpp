@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * Eliot
+ * Copyright (C) 2026 agent
+ * Authors: agent <agent @@ local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include "regexp_cursor.h"
+#include "dic.h"
+#include "header.h"
+#include "dic_internals.h"
+#include "automaton.h"
+
+
+INIT_LOGGER(dic, RegexpCursor);
+
+
+RegexpCursor::RegexpCursor(const Dictionary &iDic, const wstring &iRegexp,
+                           unsigned int iMinLength, unsigned int iMaxLength)
+    : m_dic(iDic), m_minLength(iMinLength), m_maxLength(iMaxLength),
+      m_hasPending(false)
+{
+    if (iRegexp == L"" || iMaxLength == 0)
+        return;
+
+    m_automaton = iDic.m_automatonCache->getAutomaton(iRegexp);
+    m_word.reserve(DIC_WORD_MAX);
+
+    // Start with the edges of the root
+    Frame root;
+    root.edge = iDic.getEdgeAt(iDic.getEdgeAt(iDic.getRoot())->ptr);
+    root.state = m_automaton->getInitId();
+    m_stack.push_back(root);
+}
+
+
+bool RegexpCursor::getNextWords(vector<wdstring> &oWordList,
+                                unsigned int iNbWords)
+{
+    for (unsigned int i = 0; i < iNbWords; ++i)
+    {
+        if (m_hasPending)
+        {
+            oWordList.push_back(m_pending);
+            m_hasPending = false;
+        }
+        else
+        {
+            oWordList.push_back(wdstring());
+            if (!findNextWord(oWordList.back()))
+            {
+                oWordList.pop_back();
+                return true;
+            }
+        }
+    }
+
+    // Look for one more word, to know if there are additional words
+    if (!m_hasPending)
+        m_hasPending = findNextWord(m_pending);
+    return !m_hasPending;
+}
+
+
+bool RegexpCursor::findNextWord(wdstring &oWord)
+{
+    // Same walk as Dictionary::searchRegexpRec(), without recursion
+    while (!m_stack.empty())
+    {
+        Frame &frame = m_stack.back();
+        if (frame.edge == NULL)
+        {
+            // All the edges of the node have been followed
+            m_stack.pop_back();
+            if (!m_word.empty())
+                m_word.erase(m_word.size() - 1);
+            continue;
+        }
+
+        const DicEdge *current = frame.edge;
+        frame.edge = current->last ? NULL : current + 1;
+        const unsigned int nextState =
+            m_automaton->getNextState(frame.state, current->chr);
+        if (nextState == 0)
+            continue;
+
+        m_word.push_back(current->chr);
+        const bool found = m_automaton->accept(nextState) && current->term &&
+            m_word.size() >= m_minLength;
+        if (found)
+        {
+            oWord.clear();
+            for (unsigned int i = 0; i < m_word.size(); ++i)
+                oWord += m_dic.getHeader().getDisplayStr(m_word[i]);
+        }
+
+        // Longer words cannot match
+        if (m_word.size() < m_maxLength && current->ptr)
+        {
+            Frame child;
+            child.edge = m_dic.getEdgeAt(current->ptr);
+            child.state = nextState;
+            m_stack.push_back(child);
+        }
+        else
+            m_word.erase(m_word.size() - 1);
+
+        if (found)
+            return true;
+    }
+    return false;
+}
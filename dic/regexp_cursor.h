@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * Eliot
+ * Copyright (C) 2026 agent
+ * Authors: agent <agent @@ local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef REGEXP_CURSOR_H_
+#define REGEXP_CURSOR_H_
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "dic.h"
+#include "logging.h"
+
+class Automaton;
+struct DicEdge;
+
+
+/**
+ * Cursor on the words matching a regular expression, in dictionary order.
+ * Contrary to Dictionary::searchRegExp(), the words are retrieved page by
+ * page: the walk of the dictionary is suspended after each page, and
+ * resumed where it stopped for the next one.
+ *
+ * The cursor must not be used after the destruction of its dictionary.
+ */
+class RegexpCursor
+{
+    DEFINE_LOGGER();
+public:
+    /**
+     * Constructor
+     * @param iDic: dictionary where to search the words
+     * @param iRegexp: regular expression
+     * @param iMinLength: minimal length of the words
+     * @param iMaxLength: maximal length of the words
+     * @throw InvalidRegexpException When the regular expression cannot be parsed
+     */
+    RegexpCursor(const Dictionary &iDic, const wstring &iRegexp,
+                 unsigned int iMinLength, unsigned int iMaxLength);
+
+    /**
+     * Append the next matching words to oWordList
+     * @param oWordList: results
+     * @param iNbWords: maximum number of words to append
+     * @return true if all the matching words have now been returned,
+     *      false if there are additional words
+     */
+    bool getNextWords(vector<wdstring> &oWordList, unsigned int iNbWords);
+
+    /// Return true if all the matching words have been returned
+    bool isFinished() const { return m_stack.empty() && !m_hasPending; }
+
+private:
+    const Dictionary &m_dic;
+    boost::shared_ptr<const Automaton> m_automaton;
+    unsigned int m_minLength;
+    unsigned int m_maxLength;
+
+    /// Position of the walk at a given depth
+    struct Frame
+    {
+        /// Next edge to follow (NULL when all the edges have been followed)
+        const DicEdge *edge;
+        /// State of the automaton at this depth
+        unsigned int state;
+    };
+
+    /**
+     * Walk of the dictionary: the frame at depth d is on the node reached
+     * with the first d letters of m_word
+     */
+    vector<Frame> m_stack;
+
+    /// Codes of the current word
+    string m_word;
+
+    /**
+     * Word found after the last page, to know whether there were
+     * additional words
+     */
+    wdstring m_pending;
+    bool m_hasPending;
+
+    /**
+     * Continue the walk until the next matching word
+     * @return false if there is no more matching word
+     */
+    bool findNextWord(wdstring &oWord);
+};
+
+#endif /* REGEXP_CURSOR_H_ */
@@ -36,6 +36,7 @@ INIT_LOGGER(dic, Tile);
 
 
 const Header * Tile::m_header = NULL;
+Tile::LetterInfo Tile::m_letters[kNbCodes] = { { kTILE_DUMMY, 0, 0, false, false } };
 Tile Tile::m_TheJoker;
 
 
@@ -43,22 +44,18 @@ Tile::Tile(wchar_t c)
 {
     if (iswalpha(c))
     {
-        m_joker = iswlower(c);
-        m_char = towupper(c);
-        m_code = m_header->getCodeFromChar(m_char);
+        m_joker = iswlower(c) != 0;
+        m_code = m_header->getCodeFromChar(towupper(c));
     }
     else if (c == kTILE_JOKER)
     {
         m_joker = true;
-        m_char = kTILE_JOKER;
-        m_code = m_header->getCodeFromChar(m_char);
+        m_code = m_header->getCodeFromChar(kTILE_JOKER);
     }
     else if (c == kTILE_DUMMY)
     {
-        // The char and the code are chosen to be different from any possible
-        // real tile
+        // The code is chosen to be different from any possible real tile
         m_joker = false;
-        m_char = kTILE_DUMMY;
         m_code = 0;
     }
     else
@@ -72,41 +69,14 @@ Tile::Tile(wchar_t c)
 
 Tile::Tile(unsigned int iCode, bool isJoker)
 {
+    if (iCode == 0 || iCode > m_header->getMaxCode())
+    {
+        ostringstream ss;
+        ss << "Tile::Tile: No letter for code " << iCode;
+        throw DicException(ss.str());
+    }
     m_joker = isJoker;
     m_code = iCode;
-    m_char = m_header->getCharFromCode(iCode);
-}
-
-
-bool Tile::isVowel() const
-{
-    if (m_code == 0)
-        throw DicException("Tile::isVowel: Invalid tile");
-    return m_header->isVowel(m_code);
-}
-
-
-bool Tile::isConsonant() const
-{
-    if (m_code == 0)
-        throw DicException("Tile::isConsonant: Invalid tile");
-    return m_header->isConsonant(m_code);
-}
-
-
-unsigned int Tile::maxNumber() const
-{
-    if (m_code == 0)
-        throw DicException("Tile::maxNumber: Invalid tile");
-    return m_header->getFrequency(m_code);
-}
-
-
-unsigned int Tile::getPoints() const
-{
-    if (m_code == 0)
-        throw DicException("Tile::getPoints: Invalid tile");
-    return m_header->getPoints(m_code);
 }
 
 
@@ -114,7 +84,7 @@ wstring Tile::getDisplayStr() const
 {
     if (m_code == 0)
         throw DicException("Tile::getDisplayStr: Invalid tile");
-    if (m_joker && iswalpha(m_char))
+    if (m_joker && iswalpha(m_letters[m_code].chr))
     {
         return ::toLower(m_header->getDisplayStr(m_code));
     }
@@ -133,36 +103,31 @@ vector<wistring> Tile::getInputStr() const
 
 wchar_t Tile::toChar() const
 {
+    const wchar_t chr = m_letters[m_code].chr;
     if (m_joker)
     {
-        if (iswalpha(m_char))
-            return towlower(m_char);
+        if (iswalpha(chr))
+            return towlower(chr);
         else
             return kTILE_JOKER;
     }
-    return m_char;
-}
-
-
-unsigned int Tile::toCode() const
-{
-    return m_code;
+    return chr;
 }
 
 
 Tile Tile::toLower() const
 {
-    ASSERT(iswalpha(m_char),
+    ASSERT(iswalpha(m_letters[m_code].chr),
            "toLower() should be called on alphabetical tiles");
-    return Tile(towlower(m_char));
+    return Tile(m_code, true);
 }
 
 
 Tile Tile::toUpper() const
 {
-    ASSERT(iswalpha(m_char),
+    ASSERT(iswalpha(m_letters[m_code].chr),
            "toUpper() should be called on alphabetical tiles");
-    return Tile(towupper(m_char));
+    return Tile(m_code, false);
 }
 
 
@@ -173,26 +138,32 @@ bool Tile::operator<(const Tile &iOther) const
     else if (iOther.m_joker)
         return true;
     else
-        return m_char < iOther.m_char;
+        return m_letters[m_code].chr < m_letters[iOther.m_code].chr;
 }
 
 
-bool Tile::operator==(const Tile &iOther) const
-{
-    return m_char == iOther.m_char
-        && m_joker == iOther.m_joker;
-}
-
-
-bool Tile::operator!=(const Tile &iOther) const
-{
-    return !(*this == iOther);
-}
-
 void Tile::SetHeader(const Header &iHeader)
 {
     m_header = &iHeader;
 
+    // Copy the properties of the letters, to access them directly
+    for (unsigned int code = 1; code < kNbCodes; ++code)
+    {
+        LetterInfo &info = m_letters[code];
+        if (code <= iHeader.getMaxCode())
+        {
+            info.chr = iHeader.getCharFromCode(code);
+            info.points = iHeader.getPoints(code);
+            info.frequency = iHeader.getFrequency(code);
+            info.vowel = iHeader.isVowel(code);
+            info.consonant = iHeader.isConsonant(code);
+        }
+        else
+        {
+            info = m_letters[0];
+        }
+    }
+
     // The joker tile depends on the dictionary,
     // because its code may be different
     // But since it might be valid to play without jokers,
@@ -25,8 +25,10 @@
 #include <list>
 #include <vector>
 #include <string>
+#include <stdint.h>
 
 #include "logging.h"
+#include "debug.h"
 
 using namespace std;
 
@@ -35,7 +37,11 @@ class Header;
 
 /**
  * A Tile is the internal representation
- * used within the dictionary to handle letters
+ * used within the dictionary to handle letters.
+ * It only holds the code of the letter and the joker flag, on a single
+ * byte, so that the racks, rounds and boards manipulated by the search
+ * are as small as possible. The properties of the letters are read in
+ * tables indexed by code, filled when the dictionary is loaded.
  */
 class Tile
 {
@@ -52,15 +58,31 @@ public:
     // Second constructor, used when the code of the tile is known
     Tile(unsigned int iCode, bool isJoker);
 
-    bool isEmpty() const        { return m_char == kTILE_DUMMY; }
+    bool isEmpty() const        { return m_code == 0; }
     bool isJoker() const        { return m_joker; }
-    bool isPureJoker() const    { return m_char == kTILE_JOKER; }
-    bool isVowel() const;
-    bool isConsonant() const;
-    unsigned int maxNumber() const;
-    unsigned int getPoints() const;
+    bool isPureJoker() const    { return m_letters[m_code].chr == kTILE_JOKER; }
+    bool isVowel() const
+    {
+        ASSERT(m_code != 0, "Tile::isVowel: Invalid tile");
+        return m_letters[m_code].vowel;
+    }
+    bool isConsonant() const
+    {
+        ASSERT(m_code != 0, "Tile::isConsonant: Invalid tile");
+        return m_letters[m_code].consonant;
+    }
+    unsigned int maxNumber() const
+    {
+        ASSERT(m_code != 0, "Tile::maxNumber: Invalid tile");
+        return m_letters[m_code].frequency;
+    }
+    unsigned int getPoints() const
+    {
+        ASSERT(m_code != 0, "Tile::getPoints: Invalid tile");
+        return m_letters[m_code].points;
+    }
     wchar_t toChar() const;
-    unsigned int toCode() const;
+    unsigned int toCode() const { return m_code; }
     wstring getDisplayStr() const;
     vector<wstring> getInputStr() const;
 
@@ -72,22 +94,40 @@ public:
     static const Tile &Joker()  { return m_TheJoker; }
 
     bool operator <(const Tile &iOther) const;
-    bool operator ==(const Tile &iOther) const;
-    bool operator !=(const Tile &iOther) const;
+    bool operator ==(const Tile &iOther) const
+    {
+        return m_code == iOther.m_code && m_joker == iOther.m_joker;
+    }
+    bool operator !=(const Tile &iOther) const { return !(*this == iOther); }
 
 private:
-    wchar_t m_char;
-    bool m_joker;
-
     /**
-     * Internal code, used in the dictionary to represent the letter.
-     * It is mainly used by the Cross class.
+     * Internal code, used in the dictionary to represent the letter
+     * (0 for the dummy tile). It is mainly used by the Cross class.
      */
-    int m_code;
+    uint8_t m_code : 6;
+    uint8_t m_joker : 1;
 
     static const wchar_t kTILE_DUMMY = L'%';
     static const wchar_t kTILE_JOKER = L'?';
 
+    /// Number of possible codes (the codes of the edges have 6 bits)
+    static const unsigned int kNbCodes = 64;
+
+    /// Properties of a letter
+    struct LetterInfo
+    {
+        /// Letter (uppercase)
+        wchar_t chr;
+        uint8_t points;
+        uint8_t frequency;
+        bool vowel;
+        bool consonant;
+    };
+
+    /// Properties of the letters, indexed by code (kTILE_DUMMY for code 0)
+    static LetterInfo m_letters[kNbCodes];
+
     // Special tiles are declared static
     static Tile m_TheJoker;
 
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * Eliot
+ * Copyright (C) 2026 agent
+ * Authors: agent <agent @@ local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#include "config.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cwctype>
+#include <boost/format.hpp>
+
+#if HAVE_SYS_MMAN_H && HAVE_MMAP
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   define DIC_USE_MMAP 1
+#endif
+
+#if ENABLE_NLS
+#   include <libintl.h>
+#   define _(String) gettext(String)
+#else
+#   define _(String) String
+#endif
+
+#include "word_list_reader.h"
+#include "dic_exception.h"
+#include "encoding.h"
+
+// Useful shortcut
+#define fmt(a) boost::format(a)
+
+// Size of the lookup table (Basic Multilingual Plane)
+static const unsigned int kTableSize = 0x10000;
+
+
+INIT_LOGGER(dic, WordListReader);
+
+
+WordListReader::WordListReader(const string &iFileName, const wstring &iLetters)
+    : m_data(NULL), m_size(0), m_pos(0), m_lineNb(0), m_mapAddr(NULL),
+      m_letterTable(kTableSize, 0)
+{
+    // Both the upper case and lower case versions of the letters are
+    // accepted, and converted to upper case
+    for (unsigned int i = 0; i < iLetters.size(); ++i)
+    {
+        const wchar_t upChar = iLetters[i];
+        const wchar_t lowChar = towlower(upChar);
+        if ((unsigned int)upChar < kTableSize && (unsigned int)lowChar < kTableSize)
+        {
+            m_letterTable[upChar] = upChar;
+            m_letterTable[lowChar] = upChar;
+        }
+        else
+            m_otherLetters += upChar;
+    }
+
+#ifdef DIC_USE_MMAP
+    int fd = open(iFileName.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat statBuf;
+        if (fstat(fd, &statBuf) == 0)
+        {
+            if (statBuf.st_size == 0)
+            {
+                // Nothing to read (and nothing to map)
+                close(fd);
+                return;
+            }
+            void *addr = mmap(NULL, statBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                m_mapAddr = addr;
+                m_data = (const char*)addr;
+                m_size = statBuf.st_size;
+#ifdef MADV_SEQUENTIAL
+                madvise(addr, m_size, MADV_SEQUENTIAL);
+#endif
+            }
+        }
+        // The mapping stays valid after the file descriptor is closed
+        close(fd);
+    }
+    if (m_mapAddr != NULL)
+        return;
+#endif
+
+    // Read the whole file
+    ifstream file(iFileName.c_str(), ios::in | ios::binary);
+    if (!file.is_open())
+        throw DicException((fmt(_("Could not open file '%1%'")) % iFileName).str());
+    file.seekg(0, ios::end);
+    const streamoff size = file.tellg();
+    file.seekg(0, ios::beg);
+    if (size > 0)
+    {
+        m_buffer.resize(size);
+        file.read(&m_buffer.front(), size);
+        if (file.gcount() != size)
+            throw DicException((fmt(_("Could not open file '%1%'")) % iFileName).str());
+        m_data = &m_buffer.front();
+        m_size = size;
+    }
+}
+
+
+WordListReader::~WordListReader()
+{
+#ifdef DIC_USE_MMAP
+    if (m_mapAddr != NULL)
+        munmap(m_mapAddr, m_size);
+#endif
+}
+
+
+wchar_t WordListReader::toLetter(unsigned int iChar) const
+{
+    if (iChar < kTableSize)
+        return m_letterTable[iChar];
+    const wchar_t upChar = towupper(iChar);
+    if (m_otherLetters.find(upChar) != wstring::npos)
+        return upChar;
+    return 0;
+}
+
+
+void WordListReader::throwError(unsigned int iCol, const string &iMessage) const
+{
+    ostringstream oss;
+    oss << fmt(_("Error in the word list on line %1%, col %2%: %3%"))
+        % m_lineNb % iCol % iMessage;
+    throw DicException(oss.str());
+}
+
+
+bool WordListReader::readWord(wstring &oWord, unsigned int &oLineNb)
+{
+    while (m_pos < m_size)
+    {
+        // Find the end of the line (memchr is usually well optimized)
+        const char *lineStart = m_data + m_pos;
+        const char *lineEnd = (const char*)memchr(lineStart, '\n', m_size - m_pos);
+        if (lineEnd == NULL)
+            lineEnd = m_data + m_size;
+        m_pos = lineEnd - m_data + 1;
+        ++m_lineNb;
+
+        // If there is a BOM in the file, remove it from the first word
+        if (m_lineNb == 1 && lineEnd - lineStart >= 3 &&
+            (uint8_t)lineStart[0] == 0xEF &&
+            (uint8_t)lineStart[1] == 0xBB &&
+            (uint8_t)lineStart[2] == 0xBF)
+        {
+            lineStart += 3;
+        }
+        // Remove potential \r
+        if (lineEnd > lineStart && lineEnd[-1] == '\r')
+            --lineEnd;
+        // Ignore empty lines
+        if (lineEnd == lineStart)
+            continue;
+
+        // Decode the UTF-8 characters, and convert them to letters
+        oWord.clear();
+        const uint8_t *p = (const uint8_t*)lineStart;
+        const uint8_t *end = (const uint8_t*)lineEnd;
+        while (p < end)
+        {
+            unsigned int ch = *p++;
+            if (ch >= 0x80)
+            {
+                // Length of the sequence, from the first byte
+                unsigned int nbFollowing = 0;
+                if ((ch & 0xE0) == 0xC0)
+                {
+                    ch &= 0x1F;
+                    nbFollowing = 1;
+                }
+                else if ((ch & 0xF0) == 0xE0)
+                {
+                    ch &= 0x0F;
+                    nbFollowing = 2;
+                }
+                else if ((ch & 0xF8) == 0xF0)
+                {
+                    ch &= 0x07;
+                    nbFollowing = 3;
+                }
+                else
+                    throwError(oWord.size() + 1, _("invalid UTF-8 sequence"));
+                if ((unsigned int)(end - p) < nbFollowing)
+                    throwError(oWord.size() + 1, _("invalid UTF-8 sequence"));
+                for (; nbFollowing > 0; --nbFollowing, ++p)
+                {
+                    if ((*p & 0xC0) != 0x80)
+                        throwError(oWord.size() + 1, _("invalid UTF-8 sequence"));
+                    ch = (ch << 6) | (*p & 0x3F);
+                }
+            }
+
+            const wchar_t letter = toLetter(ch);
+            if (letter == 0)
+            {
+                ostringstream oss;
+                oss << fmt(_("invalid character '%1%' (val=%2%)"))
+                    % lfw((wchar_t)ch) % ch;
+                throwError(oWord.size() + 1, oss.str());
+            }
+            oWord += letter;
+        }
+
+        oLineNb = m_lineNb;
+        return true;
+    }
+    return false;
+}
+
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * Eliot
+ * Copyright (C) 2026 agent
+ * Authors: agent <agent @@ local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef WORD_LIST_READER_H_
+#define WORD_LIST_READER_H_
+
+#include <string>
+#include <vector>
+
+#include "logging.h"
+
+using namespace std;
+
+
+/**
+ * Sequential reader of a word list file (encoded in UTF-8, one word per
+ * line), used to compile dictionaries.
+ *
+ * The file is mapped in memory when possible (read at once otherwise),
+ * and the lines are decoded directly, without intermediate copies.
+ * The characters are converted to the (upper case) letters of the
+ * dictionary with a lookup table, so any character which is not a letter
+ * of the dictionary (in upper or lower case) is rejected, with its
+ * line and column.
+ * Empty lines are skipped, and a potential BOM or carriage return
+ * is ignored.
+ */
+class WordListReader
+{
+    DEFINE_LOGGER();
+public:
+    /**
+     * Constructor
+     * @param iFileName: Name (and path) of the word list file
+     * @param iLetters: Letters of the dictionary, in upper case
+     * @exception: Throw a DicException if the file cannot be read
+     */
+    WordListReader(const string &iFileName, const wstring &iLetters);
+    ~WordListReader();
+
+    /// Size of the file, in bytes
+    size_t getSize() const { return m_size; }
+
+    /**
+     * Read the next word
+     * @param oWord: Read word, in upper case
+     * @param oLineNb: Line of the word in the file (starting from 1)
+     * @return false if there is no more word in the file
+     * @exception: Throw a DicException in case of invalid character
+     */
+    bool readWord(wstring &oWord, unsigned int &oLineNb);
+
+private:
+    // Prevent from copying the reader
+    WordListReader(const WordListReader&);
+    WordListReader &operator=(const WordListReader&);
+
+    /// File contents
+    const char *m_data;
+    size_t m_size;
+    /// Position of the next line in m_data
+    size_t m_pos;
+    /// Number of the last read line
+    unsigned int m_lineNb;
+
+    /// Start of the file mapping, or NULL if the file was read
+    void *m_mapAddr;
+    /// File contents, when the file could not be mapped
+    vector<char> m_buffer;
+
+    /**
+     * Letter corresponding to each character of the Basic Multilingual
+     * Plane (0 for the characters which are not letters)
+     */
+    vector<wchar_t> m_letterTable;
+    /// Letters of the dictionary outside the Basic Multilingual Plane
+    wstring m_otherLetters;
+
+    /// Return the letter for the given character, or 0
+    wchar_t toLetter(unsigned int iChar) const;
+
+    /// Throw an exception for an invalid character
+    void throwError(unsigned int iCol, const string &iMessage) const;
+};
+
+#endif
+
@@ -26,6 +26,7 @@
 #include "results.h"
 #include "board.h"
 #include "ai_percent.h"
+#include "settings.h"
 
 
 INIT_LOGGER(game, AIPercent);
@@ -59,6 +60,7 @@ void AIPercent::compute(const Dictionary &iDic, const Board &iBoard, bool iFirst
     m_results->clear();
 
     const Rack &rack = getCurrentRack().getRack();
+    m_results->setNbThreads(Settings::Instance().getInt("general.search-threads"));
     m_results->search(iDic, iBoard, rack, iFirstWord);
 }
 
@@ -78,6 +78,7 @@ void Arbitration::search(LimitResults &oResults)
     LOG_DEBUG("Performing search for rack " + lfw(rack.toString()));
     int limit = Settings::Instance().getInt("arbitration.search-limit");
     oResults.setLimit(limit);
+    oResults.setNbThreads(Settings::Instance().getInt("general.search-threads"));
     oResults.search(getDic(), getBoard(), rack, getHistory().beforeFirstRound());
     LOG_DEBUG("Found " << oResults.size() << " results");
 }
@@ -19,8 +19,18 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  *****************************************************************************/
 
+#include "config.h"
+
 #include <cwctype>
 #include <cstdio>
+#include <boost/foreach.hpp>
+
+#if HAVE_BOOST_THREAD
+#   include <boost/thread/thread.hpp>
+#   include <boost/thread/mutex.hpp>
+#   include <boost/thread/condition_variable.hpp>
+#   include <boost/shared_ptr.hpp>
+#endif
 
 #include "dic.h"
 
@@ -35,23 +45,18 @@
 #include "encoding.h"
 #include "debug.h"
 
-#define BOARD_REALDIM (BOARD_DIM + 2)
-
-
 INIT_LOGGER(game, Board);
 
 
 Board::Board(const GameParams &iParams):
     m_params(iParams), m_layout(iParams.getBoardLayout()),
-    m_tilesRow(BOARD_REALDIM, Tile()),
-    m_tilesCol(BOARD_REALDIM, Tile()),
-    m_jokerRow(BOARD_REALDIM, false),
-    m_jokerCol(BOARD_REALDIM, false),
-    m_crossRow(BOARD_REALDIM, Cross()),
-    m_crossCol(BOARD_REALDIM, Cross()),
-    m_pointRow(BOARD_REALDIM, -1),
-    m_pointCol(BOARD_REALDIM, -1),
-    m_testsRow(BOARD_REALDIM, Tile()),
+    m_tilesRow(Tile()),
+    m_tilesCol(Tile()),
+    m_crossRow(Cross()),
+    m_crossCol(Cross()),
+    m_pointRow(-1),
+    m_pointCol(-1),
+    m_testsRow(Tile()),
     m_isEmpty(true)
 {
     // No cross check allowed around the board
@@ -88,7 +93,7 @@ wstring Board::getDisplayStr(int iRow, int iCol) const
 
 bool Board::isJoker(int iRow, int iCol) const
 {
-    return m_jokerRow[iRow][iCol];
+    return m_tilesRow[iRow][iCol].isJoker();
 }
 
 
@@ -112,9 +117,7 @@ void Board::addRound(const Dictionary &iDic, const Round &iRound)
             {
                 ASSERT(iRound.isPlayedFromRack(i), "Invalid round (1)");
                 m_tilesRow[row][col + i] = t;
-                m_jokerRow[row][col + i] = iRound.isJoker(i);
                 m_tilesCol[col + i][row] = t;
-                m_jokerCol[col + i][row] = iRound.isJoker(i);
             }
             else
             {
@@ -132,9 +135,7 @@ void Board::addRound(const Dictionary &iDic, const Round &iRound)
             {
                 ASSERT(iRound.isPlayedFromRack(i), "Invalid round (1)");
                 m_tilesRow[row + i][col] = t;
-                m_jokerRow[row + i][col] = iRound.isJoker(i);
                 m_tilesCol[col][row + i] = t;
-                m_jokerCol[col][row + i] = iRound.isJoker(i);
             }
             else
             {
@@ -143,9 +144,10 @@ void Board::addRound(const Dictionary &iDic, const Round &iRound)
             }
         }
     }
-    buildCross(iDic);
+    updateCross(iDic, iRound);
 #ifdef DEBUG
     checkDouble();
+    checkCross(iDic);
 #endif
 
     removeTestRound();
@@ -167,12 +169,10 @@ void Board::removeRound(const Dictionary &iDic, const Round &iRound)
                    "Invalid round removal");
             if (iRound.isPlayedFromRack(i))
             {
-                ASSERT(iRound.isJoker(i) == m_jokerRow[row][col + i],
+                ASSERT(iRound.isJoker(i) == m_tilesRow[row][col + i].isJoker(),
                        "Invalid round removal");
                 m_tilesRow[row][col + i] = Tile();
-                m_jokerRow[row][col + i] = false;
                 m_tilesCol[col + i][row] = Tile();
-                m_jokerCol[col + i][row] = false;
             }
         }
     }
@@ -184,20 +184,19 @@ void Board::removeRound(const Dictionary &iDic, const Round &iRound)
                    "Invalid round removal");
             if (iRound.isPlayedFromRack(i))
             {
-                ASSERT(iRound.isJoker(i) == m_jokerRow[row + i][col],
+                ASSERT(iRound.isJoker(i) == m_tilesRow[row + i][col].isJoker(),
                        "Invalid round removal");
                 m_tilesRow[row + i][col] = Tile();
-                m_jokerRow[row + i][col] = false;
                 m_tilesCol[col][row + i] = Tile();
-                m_jokerCol[col][row + i] = false;
             }
         }
     }
 
-    // Rebuild all the cross checks, because they are now invalid
-    buildCross(iDic);
+    // Update the cross checks around the removed tiles
+    updateCross(iDic, iRound);
 #ifdef DEBUG
     checkDouble();
+    checkCross(iDic);
 #endif
 
     removeTestRound();
@@ -217,10 +216,9 @@ void Board::removeRound(const Dictionary &iDic, const Round &iRound)
 
 /* XXX: There is duplicated code with board_search.c.
  * We could probably factorize something... */
-int Board::checkRoundAux(const Matrix<Tile> &iTilesMx,
-                         const Matrix<Cross> &iCrossMx,
-                         const Matrix<int> &iPointsMx,
-                         const Matrix<bool> &iJokerMx,
+int Board::checkRoundAux(const BoardMatrix<Tile> &iTilesMx,
+                         const BoardMatrix<Cross> &iCrossMx,
+                         const BoardMatrix<int> &iPointsMx,
                          Round &iRound, bool checkJunction) const
 {
     bool isolated = true;
@@ -261,7 +259,7 @@ int Board::checkRoundAux(const Matrix<Tile> &iTilesMx,
             isolated = false;
             iRound.setFromBoard(i);
 
-            if (!iJokerMx[row][col + i])
+            if (!iTilesMx[row][col + i].isJoker())
                 pts += t.getPoints();
         }
         else
@@ -344,7 +342,7 @@ int Board::checkRound(Round &iRound, bool checkJunction) const
     if (iRound.getCoord().getDir() == Coord::HORIZONTAL)
     {
         return checkRoundAux(m_tilesRow, m_crossRow,
-                             m_pointRow, m_jokerRow, iRound, checkJunction);
+                             m_pointRow, iRound, checkJunction);
     }
     else
     {
@@ -353,7 +351,7 @@ int Board::checkRound(Round &iRound, bool checkJunction) const
         iRound.accessCoord().swap();
 
         int res = checkRoundAux(m_tilesCol, m_crossCol,
-                                m_pointCol, m_jokerCol, iRound, checkJunction);
+                                m_pointCol, iRound, checkJunction);
 
         // Restore the coordinates
         iRound.accessCoord().swap();
@@ -426,7 +424,7 @@ string Board::getCellContent_row(int row, int col) const
 {
     char buff[1024];  // [ joker, mask, point, tiles ]
     sprintf(buff,CELL_STRING_FORMAT,
-            // m_jokerRow[row][col] ? 'j':'.',
+            // m_tilesRow[row][col].isJoker() ? 'j':'.',
             m_crossRow[row][col].getHexContent().c_str(),
             m_pointRow[row][col]);
     return string(buff);
@@ -436,7 +434,7 @@ string Board::getCellContent_col(int row, int col) const
 {
     char buff[1024];
     sprintf(buff,CELL_STRING_FORMAT,
-            // m_jokerCol[col][row] ? 'j':'.',
+            // m_tilesCol[col][row].isJoker() ? 'j':'.',
             m_crossCol[col][row].getHexContent().c_str(),
             m_pointCol[col][row]);
     return string(buff);
@@ -454,32 +452,268 @@ void Board::checkDouble()
         {
             ASSERT(m_tilesRow[row][col] == m_tilesCol[col][row],
                    "Tiles inconsistency at " << row << "x" << col);
-            ASSERT(m_jokerRow[row][col] == m_jokerCol[col][row],
-                   "Jokers inconsistency at " << row << "x" << col);
             // The crossckecks and the points have no reason to be the same
             // in both directions
         }
     }
 }
+
+
+void Board::checkCross(const Dictionary &iDic) const
+{
+    // Compare with cross checks built from scratch
+    Board board(*this);
+    board.buildCross(iDic);
+    for (int row = 1; row <= BOARD_DIM; row++)
+    {
+        for (int col = 1; col <= BOARD_DIM; col++)
+        {
+            ASSERT(m_crossRow[row][col] == board.m_crossRow[row][col] &&
+                   m_crossCol[row][col] == board.m_crossCol[row][col],
+                   "Cross checks inconsistency at " << row << "x" << col);
+            ASSERT(m_pointRow[row][col] == board.m_pointRow[row][col] &&
+                   m_pointCol[row][col] == board.m_pointCol[row][col],
+                   "Cross points inconsistency at " << row << "x" << col);
+        }
+    }
+}
+#endif
+
+
+#if HAVE_BOOST_THREAD
+/// Line of the board searched by the parallel version of Board::search()
+struct line_task_t
+{
+    const BoardSearch *search;
+    Coord::Direction dir;
+    int row;
+    /// Rounds of the line, selected like the rounds of the whole board
+    boost::shared_ptr<Results> results;
+};
+
+
+/// Lines shared by the threads of the parallel version of Board::search()
+struct line_tasks_t
+{
+    const Rack *rack;
+    vector<line_task_t> tasks;
+    /// Index of the next line to search
+    unsigned int nextTask;
+};
+
+
+/**
+ * Threads helping the current thread in the parallel version of
+ * Board::search(). They are created when a search first needs them,
+ * and they wait for the next search afterwards.
+ */
+class LinesSearchPool
+{
+public:
+    static LinesSearchPool & Instance();
+
+    /// Stop and join the threads
+    ~LinesSearchPool();
+
+    /**
+     * Search all the lines of ioTasks with iNbThreads threads, including
+     * the calling one. Return when all the lines have been searched.
+     */
+    void run(line_tasks_t &ioTasks, unsigned int iNbThreads);
+
+    /// Main loop of the threads of the pool
+    void work();
+
+private:
+    /// Serializes the calls to run()
+    boost::mutex m_runMutex;
+    /// Protects all the fields below
+    boost::mutex m_mutex;
+    /// Signaled when a search starts, or when the pool is destroyed
+    boost::condition_variable m_searchStarted;
+    /// Signaled when a thread of the pool stops working on a search
+    boost::condition_variable m_threadDone;
+
+    boost::thread_group m_threads;
+    unsigned int m_nbThreads;
+
+    /// Lines of the current search (NULL between two searches)
+    line_tasks_t *m_tasks;
+    /// Number of threads of the pool which can still join the current search
+    unsigned int m_nbHelpers;
+    /// Number of threads of the pool working on the current search
+    unsigned int m_nbActive;
+    bool m_stop;
+
+    LinesSearchPool();
+
+    /**
+     * Search the lines of the current search until there are none left.
+     * ioLock must hold m_mutex, which is released during the searches.
+     */
+    void searchLines(boost::unique_lock<boost::mutex> &ioLock);
+};
+
+
+/// Functor running LinesSearchPool::work() in a thread
+class LinesSearcher
+{
+public:
+    LinesSearcher(LinesSearchPool &ioPool) : m_pool(ioPool) {}
+
+    void operator()() const { m_pool.work(); }
+
+private:
+    LinesSearchPool &m_pool;
+};
+
+
+LinesSearchPool::LinesSearchPool()
+    : m_nbThreads(0), m_tasks(NULL), m_nbHelpers(0), m_nbActive(0),
+    m_stop(false)
+{
+}
+
+
+LinesSearchPool::~LinesSearchPool()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stop = true;
+        m_searchStarted.notify_all();
+    }
+    m_threads.join_all();
+}
+
+
+LinesSearchPool & LinesSearchPool::Instance()
+{
+    static LinesSearchPool pool;
+    return pool;
+}
+
+
+void LinesSearchPool::run(line_tasks_t &ioTasks, unsigned int iNbThreads)
+{
+    boost::mutex::scoped_lock runLock(m_runMutex);
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+
+    // Create the missing threads
+    for (; m_nbThreads + 1 < iNbThreads; ++m_nbThreads)
+        m_threads.create_thread(LinesSearcher(*this));
+
+    m_tasks = &ioTasks;
+    m_nbHelpers = iNbThreads - 1;
+    m_searchStarted.notify_all();
+
+    // The current thread works too
+    searchLines(lock);
+
+    // Wait for the lines still searched by the other threads
+    while (m_nbActive > 0)
+        m_threadDone.wait(lock);
+    m_tasks = NULL;
+}
+
+
+void LinesSearchPool::work()
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (true)
+    {
+        while (!m_stop && (m_tasks == NULL || m_nbHelpers == 0))
+            m_searchStarted.wait(lock);
+        if (m_stop)
+            return;
+
+        --m_nbHelpers;
+        ++m_nbActive;
+        searchLines(lock);
+        --m_nbActive;
+        if (m_nbActive == 0)
+            m_threadDone.notify_all();
+    }
+}
+
+
+void LinesSearchPool::searchLines(boost::unique_lock<boost::mutex> &ioLock)
+{
+    line_tasks_t &tasks = *m_tasks;
+    // The search modifies the rack temporarily
+    Rack rack = *tasks.rack;
+    while (tasks.nextTask < tasks.tasks.size())
+    {
+        line_task_t &task = tasks.tasks[tasks.nextTask++];
+        ioLock.unlock();
+        task.search->search(rack, *task.results, task.dir, task.row, task.row);
+        ioLock.lock();
+    }
+    // No need to wake up more threads for this search
+    m_nbHelpers = 0;
+}
 #endif
 
 
 void Board::search(const Dictionary &iDic,
                    const Rack &iRack,
-                   Results &oResults) const
+                   Results &oResults,
+                   unsigned int iNbThreads) const
 {
+    BoardSearch horizSearch(iDic, m_params, m_tilesRow, m_crossRow,
+                            m_pointRow);
+    BoardSearch vertSearch(iDic, m_params, m_tilesCol, m_crossCol,
+                            m_pointCol);
+
+#if HAVE_BOOST_THREAD
+    if (iNbThreads == 0)
+        iNbThreads = boost::thread::hardware_concurrency();
+    // There is no use for more threads than lines
+    if (iNbThreads > 2 * BOARD_DIM)
+        iNbThreads = 2 * BOARD_DIM;
+    if (iNbThreads > 1)
+    {
+        // Each line of the board is searched independently, in both
+        // directions, with its own results
+        line_tasks_t tasks;
+        tasks.rack = &iRack;
+        tasks.tasks.resize(2 * BOARD_DIM);
+        for (int row = 1; row <= BOARD_DIM; ++row)
+        {
+            line_task_t &horizTask = tasks.tasks[row - 1];
+            horizTask.search = &horizSearch;
+            horizTask.dir = Coord::HORIZONTAL;
+            horizTask.row = row;
+            horizTask.results.reset(oResults.createSimilar());
+            line_task_t &vertTask = tasks.tasks[BOARD_DIM + row - 1];
+            vertTask.search = &vertSearch;
+            vertTask.dir = Coord::VERTICAL;
+            vertTask.row = row;
+            vertTask.results.reset(oResults.createSimilar());
+        }
+        tasks.nextTask = 0;
+
+        LinesSearchPool::Instance().run(tasks, iNbThreads);
+
+        // Give the rounds kept for each line to oResults, in the order
+        // of a serial search, so that its selection of rounds is not
+        // modified
+        BOOST_FOREACH(const line_task_t &task, tasks.tasks)
+        {
+            for (unsigned int i = 0; i < task.results->size(); ++i)
+                oResults.add(task.results->get(i));
+        }
+        return;
+    }
+#endif
+
     // Create a copy of the rack to avoid modifying the given one
     Rack copyRack = iRack;
 
     // Search horizontal words
-    BoardSearch horizSearch(iDic, m_params, m_tilesRow, m_crossRow,
-                            m_pointRow, m_jokerRow);
-    horizSearch.search(copyRack, oResults, Coord::HORIZONTAL);
+    horizSearch.search(copyRack, oResults, Coord::HORIZONTAL, 1, BOARD_DIM);
 
     // Search vertical words
-    BoardSearch vertSearch(iDic, m_params, m_tilesCol, m_crossCol,
-                            m_pointCol, m_jokerCol);
-    vertSearch.search(copyRack, oResults, Coord::VERTICAL);
+    vertSearch.search(copyRack, oResults, Coord::VERTICAL, 1, BOARD_DIM);
 }
 
 
@@ -492,7 +726,7 @@ void Board::searchFirst(const Dictionary &iDic,
 
     // Search horizontal words
     BoardSearch horizSearch(iDic, m_params, m_tilesRow, m_crossRow,
-                            m_pointRow, m_jokerRow, true);
-    horizSearch.search(copyRack, oResults, Coord::HORIZONTAL);
+                            m_pointRow, true);
+    horizSearch.search(copyRack, oResults, Coord::HORIZONTAL, 1, BOARD_DIM);
 }
 
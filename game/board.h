@@ -24,7 +24,7 @@
 
 #include <string>
 
-#include "matrix.h"
+#include "board_matrix.h"
 #include "tile.h"
 #include "cross.h"
 #include "logging.h"
@@ -38,11 +38,6 @@ class Results;
 
 using namespace std;
 
-#define BOARD_MIN 1
-#define BOARD_MAX 15
-#define BOARD_DIM 15
-
-
 /**
  * Representation of the board.
  *
@@ -75,7 +70,15 @@ public:
     void testRound(const Round &iRound);
     void removeTestRound();
 
-    void search(const Dictionary &iDic, const Rack &iRack, Results &oResults) const;
+    /**
+     * Give to oResults all the moves playable with the given rack.
+     * @param iNbThreads: number of threads searching the lines of the
+     *      board (0 means one per processor). The rounds are given to
+     *      oResults in the same order as with a single thread. Only one
+     *      thread is used if Eliot was compiled without Boost.Thread.
+     */
+    void search(const Dictionary &iDic, const Rack &iRack, Results &oResults,
+                unsigned int iNbThreads = 1) const;
     void searchFirst(const Dictionary &iDic, const Rack &iRack, Results &oResults) const;
 
     /**
@@ -90,19 +93,16 @@ private:
 
     const BoardLayout &m_layout;
 
-    Matrix<Tile> m_tilesRow;
-    Matrix<Tile> m_tilesCol;
+    BoardMatrix<Tile> m_tilesRow;
+    BoardMatrix<Tile> m_tilesCol;
 
-    Matrix<bool> m_jokerRow;
-    Matrix<bool> m_jokerCol;
+    BoardMatrix<Cross> m_crossRow;
+    BoardMatrix<Cross> m_crossCol;
 
-    Matrix<Cross> m_crossRow;
-    Matrix<Cross> m_crossCol;
+    BoardMatrix<int> m_pointRow;
+    BoardMatrix<int> m_pointCol;
 
-    Matrix<int> m_pointRow;
-    Matrix<int> m_pointCol;
-
-    Matrix<Tile> m_testsRow;
+    BoardMatrix<Tile> m_testsRow;
 
     /// Flag indicating if the board is empty or if it has letters
     bool m_isEmpty;
@@ -112,14 +112,22 @@ private:
      */
     void buildCross(const Dictionary &iDic);
 
-    int checkRoundAux(const Matrix<Tile> &iTilesMx,
-                      const Matrix<Cross> &iCrossMx,
-                      const Matrix<int> &iPointsMx,
-                      const Matrix<bool> &iJokerMx,
+    /**
+     * Update the cross checks and the cross points after the given round
+     * was added to the board or removed from it. Only the squares next to
+     * the words containing the tiles of the round are updated.
+     */
+    void updateCross(const Dictionary &iDic, const Round &iRound);
+
+    int checkRoundAux(const BoardMatrix<Tile> &iTilesMx,
+                      const BoardMatrix<Cross> &iCrossMx,
+                      const BoardMatrix<int> &iPointsMx,
                       Round &iRound,
                       bool checkJunction) const;
 #ifdef DEBUG
     void checkDouble();
+    /// Check that the cross checks are the same as after buildCross()
+    void checkCross(const Dictionary &iDic) const;
 #endif
 
 };
@@ -19,57 +19,89 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  *****************************************************************************/
 
-#include <wctype.h>
+#include <algorithm>
 
 #include <dic.h>
 #include "tile.h"
+#include "round.h"
 #include "board.h"
 #include "debug.h"
 
 
 static void Board_checkout_tile(const Dictionary &iDic,
-                                vector<Tile>& iTiles,
-                                vector<bool> & iJoker,
+                                const Tile *iTiles,
                                 Cross &oCross,
                                 int& oPoints,
                                 int index)
 {
     oPoints = 0;
 
+    // Codes of the tiles on the left and on the right of the square,
+    // terminated by 0 (the code of no letter)
+    dic_code_t leftCodes[BOARD_DIM + 1];
+    dic_code_t rightCodes[BOARD_DIM + 1];
+
     /* Points on the left part */
     int left = index;
     while (!iTiles[left - 1].isEmpty())
     {
         left--;
-        if (!iJoker[left])
+        if (!iTiles[left].isJoker())
             oPoints += iTiles[left].getPoints();
     }
 
-    // FIXME: create temporary strings until the dictionary uses Tile objects
-    wstring leftTiles;
-    wstring rightTiles;
-
+    int nbLeft = 0;
     for (int i = left; i < index; i++)
-        leftTiles.push_back(towupper(iTiles[i].toChar()));
+        leftCodes[nbLeft++] = iTiles[i].toCode();
+    leftCodes[nbLeft] = 0;
 
+    int nbRight = 0;
     for (int i = index + 1; !iTiles[i].isEmpty(); i++)
-        rightTiles.push_back(towupper(iTiles[i].toChar()));
+        rightCodes[nbRight++] = iTiles[i].toCode();
+    rightCodes[nbRight] = 0;
 
     /* Tiles that can be played */
     unsigned int node, succ;
-    node = iDic.charLookup(iDic.getRoot(), leftTiles.c_str());
-    if (node == 0)
+    if (nbLeft == 0 && iDic.hasGaddag())
     {
-        oCross.setNone();
-        return;
+        // Only tiles on the right: in the GADDAG, a word CR is stored as
+        // reverse(R), C, separator. The right part is walked only once,
+        // then each letter is accepted if the separator ends a word.
+        node = iDic.getGaddagRoot();
+        for (int i = nbRight - 1; i >= 0 && node; i--)
+            node = iDic.getSuccByCode(node, rightCodes[i]);
+
+        // The points of the right part are needed even if no tile fits
+        for (succ = node ? iDic.getSucc(node) : 0; succ; succ = iDic.getNext(succ))
+        {
+            if (iDic.getCode(succ) != DIC_GADDAG_SEPARATOR &&
+                iDic.isEndOfWord(iDic.getSuccByCode(succ, DIC_GADDAG_SEPARATOR)))
+            {
+                oCross.insert(Tile(iDic.getCode(succ), false));
+            }
+            if (iDic.isLast(succ))
+                break;
+        }
     }
-
-    for (succ = iDic.getSucc(node); succ; succ = iDic.getNext(succ))
+    else
     {
-        if (iDic.isEndOfWord(iDic.charLookup(succ, rightTiles.c_str())))
-            oCross.insert(Tile(iDic.getChar(succ)));
-        if (iDic.isLast(succ))
-            break;
+        node = iDic.lookup(iDic.getRoot(), leftCodes);
+        if (node == 0)
+        {
+            oCross.setNone();
+            return;
+        }
+
+        for (succ = iDic.getSucc(node); succ; succ = iDic.getNext(succ))
+        {
+            // Only tiles on the left: no need to walk further
+            const unsigned int end =
+                nbRight == 0 ? succ : iDic.lookup(succ, rightCodes);
+            if (iDic.isEndOfWord(end))
+                oCross.insert(Tile(iDic.getCode(succ), false));
+            if (iDic.isLast(succ))
+                break;
+        }
     }
 
     /* Points on the right part */
@@ -77,42 +109,81 @@ static void Board_checkout_tile(const Dictionary &iDic,
     while (!iTiles[index + 1].isEmpty())
     {
         index++;
-        if (!iJoker[index])
+        if (!iTiles[index].isJoker())
             oPoints += iTiles[index].getPoints();
     }
 }
 
 
+/**
+ * Update the cross check and the points of the square iIndex of the line
+ * iLine, given the tiles of this line
+ */
+static void Board_checkSquare(const Dictionary &iDic,
+                              const Tile *iTiles,
+                              BoardMatrix<Cross> &iCrossMx,
+                              BoardMatrix<int> &iPointMx,
+                              int iLine, int iIndex)
+{
+    iPointMx[iIndex][iLine] = -1;
+    if (!iTiles[iIndex].isEmpty())
+    {
+        iCrossMx[iIndex][iLine].setNone();
+    }
+    else if (!iTiles[iIndex - 1].isEmpty() ||
+             !iTiles[iIndex + 1].isEmpty())
+    {
+        iCrossMx[iIndex][iLine].setNone();
+        Board_checkout_tile(iDic, iTiles,
+                            iCrossMx[iIndex][iLine],
+                            iPointMx[iIndex][iLine],
+                            iIndex);
+    }
+    else
+    {
+        iCrossMx[iIndex][iLine].setAny();
+    }
+}
+
+
+/**
+ * Update the squares of the line iLine depending on the square iIndex:
+ * the square itself, and the first empty squares on its left and on its
+ * right (the tiles in between are part of the same word)
+ */
+static void Board_checkAround(const Dictionary &iDic,
+                              const Tile *iTiles,
+                              BoardMatrix<Cross> &iCrossMx,
+                              BoardMatrix<int> &iPointMx,
+                              int iLine, int iIndex)
+{
+    Board_checkSquare(iDic, iTiles, iCrossMx, iPointMx, iLine, iIndex);
+
+    // The squares around the board are always empty
+    int left = iIndex - 1;
+    while (!iTiles[left].isEmpty())
+        left--;
+    if (left >= 1)
+        Board_checkSquare(iDic, iTiles, iCrossMx, iPointMx, iLine, left);
+
+    int right = iIndex + 1;
+    while (!iTiles[right].isEmpty())
+        right++;
+    if (right <= BOARD_DIM)
+        Board_checkSquare(iDic, iTiles, iCrossMx, iPointMx, iLine, right);
+}
+
+
 static void Board_check(const Dictionary &iDic,
-                        Matrix<Tile> &iTilesMx,
-                        Matrix<bool> &iJokerMx,
-                        Matrix<Cross> &iCrossMx,
-                        Matrix<int> &iPointMx)
+                        BoardMatrix<Tile> &iTilesMx,
+                        BoardMatrix<Cross> &iCrossMx,
+                        BoardMatrix<int> &iPointMx)
 {
     for (int i = 1; i <= BOARD_DIM; i++)
     {
         for (int j = 1; j <= BOARD_DIM; j++)
         {
-            iPointMx[j][i] = -1;
-            if (!iTilesMx[i][j].isEmpty())
-            {
-                iCrossMx[j][i].setNone();
-            }
-            else if (!iTilesMx[i][j - 1].isEmpty() ||
-                     !iTilesMx[i][j + 1].isEmpty())
-            {
-                iCrossMx[j][i].setNone();
-                Board_checkout_tile(iDic,
-                                    iTilesMx[i],
-                                    iJokerMx[i],
-                                    iCrossMx[j][i],
-                                    iPointMx[j][i],
-                                    j);
-            }
-            else
-            {
-                iCrossMx[j][i].setAny();
-            }
+            Board_checkSquare(iDic, iTilesMx[i], iCrossMx, iPointMx, i, j);
         }
     }
 }
@@ -120,7 +191,46 @@ static void Board_check(const Dictionary &iDic,
 
 void Board::buildCross(const Dictionary &iDic)
 {
-    Board_check(iDic, m_tilesRow, m_jokerRow, m_crossCol, m_pointCol);
-    Board_check(iDic, m_tilesCol, m_jokerCol, m_crossRow, m_pointRow);
+    Board_check(iDic, m_tilesRow, m_crossCol, m_pointCol);
+    Board_check(iDic, m_tilesCol, m_crossRow, m_pointRow);
+}
+
+
+void Board::updateCross(const Dictionary &iDic, const Round &iRound)
+{
+    // Only the cross checks of the squares forming a word with the
+    // squares of the round can change. To avoid handling the 2 directions
+    // separately, "line" is the line of the round and "index" the position
+    // along this line, in the matrices where the round is horizontal.
+    const bool horizontal = iRound.getCoord().getDir() == Coord::HORIZONTAL;
+    const int line = horizontal ? iRound.getCoord().getRow() : iRound.getCoord().getCol();
+    const int start = horizontal ? iRound.getCoord().getCol() : iRound.getCoord().getRow();
+    const int len = iRound.getWordLen();
+
+    BoardMatrix<Tile> &tilesMx = horizontal ? m_tilesRow : m_tilesCol;
+    BoardMatrix<Cross> &crossMx = horizontal ? m_crossCol : m_crossRow;
+    BoardMatrix<int> &pointMx = horizontal ? m_pointCol : m_pointRow;
+    BoardMatrix<Tile> &otherTilesMx = horizontal ? m_tilesCol : m_tilesRow;
+    BoardMatrix<Cross> &otherCrossMx = horizontal ? m_crossRow : m_crossCol;
+    BoardMatrix<int> &otherPointMx = horizontal ? m_pointRow : m_pointCol;
+
+    // In the line of the round, the squares of the word and the squares
+    // just before and after it (which are empty, and separate the word
+    // from the other tiles of the line)
+    for (int i = std::max(start - 1, 1); i <= std::min(start + len, BOARD_DIM); i++)
+    {
+        Board_checkSquare(iDic, tilesMx[line], crossMx, pointMx, line, i);
+    }
+
+    // In the lines crossing the round, around the squares played from
+    // the rack
+    for (int i = 0; i < len; i++)
+    {
+        if (iRound.isPlayedFromRack(i))
+        {
+            Board_checkAround(iDic, otherTilesMx[start + i],
+                              otherCrossMx, otherPointMx, start + i, line);
+        }
+    }
 }
 
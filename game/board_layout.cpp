@@ -29,9 +29,6 @@
 #define W2 2
 #define W3 3
 
-#define BOARD_DIM 15
-#define BOARD_REALDIM (BOARD_DIM + 2)
-
 
 INIT_LOGGER(game, BoardLayout);
 
@@ -92,17 +89,13 @@ BoardLayout::BoardLayout()
 
 unsigned BoardLayout::getRowCount() const
 {
-    ASSERT(m_wordMultipliers.size() > 2 && m_tileMultipliers.size() > 2,
-           "Invalid board size");
-    return m_wordMultipliers.size() - 2;
+    return BOARD_DIM;
 }
 
 
 unsigned BoardLayout::getColCount() const
 {
-    ASSERT(m_wordMultipliers.size() > 2 && m_tileMultipliers.size() > 2,
-           "Invalid board size");
-    return m_wordMultipliers[0].size() - 2;
+    return BOARD_DIM;
 }
 
 
@@ -129,9 +122,8 @@ bool BoardLayout::isValidCoord(unsigned iRow, unsigned iCol) const
 }
 
 
-static void InitMatrixFromArray(Matrix<int> &oMatrix, const int iArray[BOARD_REALDIM][BOARD_REALDIM])
+static void InitMatrixFromArray(BoardMatrix<int> &oMatrix, const int iArray[BOARD_REALDIM][BOARD_REALDIM])
 {
-    oMatrix.resize(BOARD_REALDIM, BOARD_REALDIM, 0);
     for (unsigned i = 0; i < BOARD_REALDIM; ++i)
     {
         for (unsigned j = 0; j < BOARD_REALDIM; ++j)
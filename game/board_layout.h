@@ -21,7 +21,7 @@
 #ifndef BOARD_LAYOUT_H_
 #define BOARD_LAYOUT_H_
 
-#include "matrix.h"
+#include "board_matrix.h"
 #include "logging.h"
 
 
@@ -47,8 +47,8 @@ private:
 
     static BoardLayout m_defaultLayout;
 
-    Matrix<int> m_wordMultipliers;
-    Matrix<int> m_tileMultipliers;
+    BoardMatrix<int> m_wordMultipliers;
+    BoardMatrix<int> m_tileMultipliers;
 
     void setDefaultLayout();
 
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * Eliot
+ * Copyright (C) 2026 agent
+ * Authors: agent <agent @@ local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *****************************************************************************/
+
+#ifndef BOARD_MATRIX_H_
+#define BOARD_MATRIX_H_
+
+#include <algorithm>
+
+#define BOARD_MIN 1
+#define BOARD_MAX 15
+#define BOARD_DIM 15
+
+/// Size of the matrices, including the (always empty) squares around the board
+#define BOARD_REALDIM (BOARD_DIM + 2)
+
+
+/**
+ * Matrix holding one value for each square of the board and of its
+ * borders. The dimensions are known at compile time, and the values are
+ * stored row by row in a single array, so that m[row][col] only costs
+ * one indexed access.
+ *
+ * The board uses one such matrix per property of the squares (tiles,
+ * cross checks, points), so that the search only reads the properties
+ * it needs.
+ */
+template <class T>
+class BoardMatrix
+{
+public:
+    /// Construct a matrix with an initial value
+    explicit BoardMatrix(const T &iValue = T())
+    {
+        fill(iValue);
+    }
+
+    /// Set all the values of the matrix
+    void fill(const T &iValue)
+    {
+        std::fill(m_values, m_values + kNbValues, iValue);
+    }
+
+    /// Return the row iRow, indexed by column
+    T * operator[](int iRow) { return m_values + iRow * BOARD_REALDIM; }
+    const T * operator[](int iRow) const { return m_values + iRow * BOARD_REALDIM; }
+
+private:
+    static const int kNbValues = BOARD_REALDIM * BOARD_REALDIM;
+
+    T m_values[kNbValues];
+};
+
+#endif
+
@@ -19,7 +19,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  *****************************************************************************/
 
-#include <cwctype> // For towupper
+#include <algorithm>
 
 #include "board_search.h"
 #include "dic.h"
@@ -33,19 +33,25 @@
 
 BoardSearch::BoardSearch(const Dictionary &iDic,
                          const GameParams &iParams,
-                         const Matrix<Tile> &iTilesMx,
-                         const Matrix<Cross> &iCrossMx,
-                         const Matrix<int> &iPointsMx,
-                         const Matrix<bool> &iJokerMx,
+                         const BoardMatrix<Tile> &iTilesMx,
+                         const BoardMatrix<Cross> &iCrossMx,
+                         const BoardMatrix<int> &iPointsMx,
                          bool isFirstTurn)
     : m_dic(iDic), m_params(iParams), m_tilesMx(iTilesMx), m_crossMx(iCrossMx),
-      m_pointsMx(iPointsMx), m_jokerMx(iJokerMx), m_firstTurn(isFirstTurn)
+      m_pointsMx(iPointsMx), m_firstTurn(isFirstTurn)
 {
 }
 
 
-void BoardSearch::search(Rack &iRack, Results &oResults, Coord::Direction iDir) const
+void BoardSearch::search(Rack &iRack, Results &oResults, Coord::Direction iDir,
+                         int iFirstRow, int iLastRow) const
 {
+    if (m_dic.hasGaddag())
+    {
+        searchGaddag(iRack, oResults, iDir, iFirstRow, iLastRow);
+        return;
+    }
+
     // Handle the first turn specifically
     if (m_firstTurn)
     {
@@ -60,11 +66,9 @@ void BoardSearch::search(Rack &iRack, Results &oResults, Coord::Direction iDir)
     }
 
 
-    vector<Tile> rackTiles;
-    iRack.getTiles(rackTiles);
-    vector<Tile>::const_iterator it;
+    const uint64_t rackMask = iRack.getCodesMask();
 
-    for (int row = 1; row <= BOARD_DIM; row++)
+    for (int row = iFirstRow; row <= iLastRow; row++)
     {
         Round partialWord;
         partialWord.accessCoord().setDir(iDir);
@@ -96,16 +100,7 @@ void BoardSearch::search(Rack &iRack, Results &oResults, Coord::Direction iDir)
                 // Optimization compared to the original Appel & Jacobson
                 // algorithm: skip leftPart if none of the tiles of the rack
                 // matches the cross mask for the current anchor
-                bool match = false;
-                for (it = rackTiles.begin(); it != rackTiles.end(); it++)
-                {
-                    if (m_crossMx[row][col].check(*it))
-                    {
-                        match = true;
-                        break;
-                    }
-                }
-                if (match)
+                if (m_crossMx[row][col].checkMask(rackMask))
                 {
                     if (!m_tilesMx[row][col - 1].isEmpty())
                     {
@@ -139,7 +134,7 @@ void BoardSearch::leftPart(Rack &iRack, Round &ioPartialWord,
         bool hasJokerInRack = iRack.contains(Tile::Joker());
         for (unsigned int succ = m_dic.getSucc(n); succ; succ = m_dic.getNext(succ))
         {
-            const Tile &l = Tile(m_dic.getChar(succ));
+            const Tile &l = Tile(m_dic.getCode(succ), false);
             if (iRack.contains(l))
             {
                 iRack.remove(l);
@@ -185,7 +180,7 @@ void BoardSearch::extendRight(Rack &iRack, Round &ioPartialWord,
         bool hasJokerInRack = iRack.contains(Tile::Joker());
         for (unsigned int succ = m_dic.getSucc(iNode); succ; succ = m_dic.getNext(succ))
         {
-            const Tile &l = Tile(m_dic.getChar(succ));
+            const Tile &l = Tile(m_dic.getCode(succ), false);
             if (m_crossMx[iRow][iCol].check(l))
             {
                 if (iRack.contains(l))
@@ -212,18 +207,221 @@ void BoardSearch::extendRight(Rack &iRack, Round &ioPartialWord,
     else
     {
         const Tile &l = m_tilesMx[iRow][iCol];
-        wint_t upperChar = towupper(l.toChar());
-        for (unsigned int succ = m_dic.getSucc(iNode); succ ; succ = m_dic.getNext(succ))
+        // The letter is present at most once among the successors
+        const unsigned int succ = m_dic.getSuccByCode(iNode, l.toCode());
+        if (succ)
+        {
+            ioPartialWord.addRightFromBoard(l);
+            extendRight(iRack, ioPartialWord,
+                        oResults, succ, iRow, iCol + 1, iAnchor);
+            ioPartialWord.removeRight();
+        }
+    }
+}
+
+
+void BoardSearch::searchGaddag(Rack &iRack, Results &oResults,
+                               Coord::Direction iDir,
+                               int iFirstRow, int iLastRow) const
+{
+    // Handle the first turn specifically
+    if (m_firstTurn)
+    {
+        const int row = 8, col = 8;
+        Round tmpRound;
+        tmpRound.accessCoord().setRow(row);
+        tmpRound.accessCoord().setCol(col);
+        tmpRound.accessCoord().setDir(Coord::HORIZONTAL);
+        // The word must cover the center square, and the rack limits
+        // the number of letters on its left
+        const int limit = std::max(0, col - (int)iRack.getNbTiles());
+        gaddagLeft(iRack, tmpRound, oResults, m_dic.getGaddagRoot(),
+                   row, col, col, limit);
+        return;
+    }
+
+    const uint64_t rackMask = iRack.getCodesMask();
+
+    for (int row = iFirstRow; row <= iLastRow; row++)
+    {
+        Round partialWord;
+        partialWord.accessCoord().setDir(iDir);
+        partialWord.accessCoord().setRow(row);
+        int lastanchor = 0;
+        for (int col = 1; col <= BOARD_DIM; col++)
+        {
+            if (m_tilesMx[row][col].isEmpty() &&
+                (!m_tilesMx[row][col - 1].isEmpty() ||
+                 !m_tilesMx[row][col + 1].isEmpty() ||
+                 !m_tilesMx[row - 1][col].isEmpty() ||
+                 !m_tilesMx[row + 1][col].isEmpty()))
+            {
+                // Same optimization as in search(): skip the anchor if
+                // none of the tiles of the rack matches its cross mask
+                if (m_crossMx[row][col].checkMask(rackMask))
+                {
+                    // Each move is generated only from its leftmost anchor,
+                    // so the moves starting from this anchor cannot extend
+                    // to the previous one
+                    partialWord.accessCoord().setCol(col);
+                    gaddagLeft(iRack, partialWord, oResults,
+                               m_dic.getGaddagRoot(),
+                               row, col, col, lastanchor);
+                }
+                lastanchor = col;
+            }
+        }
+    }
+}
+
+
+void BoardSearch::gaddagLeft(Rack &iRack, Round &ioPartialWord,
+                             Results &oResults, unsigned int iNode,
+                             int iRow, int iCol, int iAnchor,
+                             int iLastAnchor) const
+{
+    if (!m_tilesMx[iRow][iCol].isEmpty())
+    {
+        const unsigned int code = m_tilesMx[iRow][iCol].toCode();
+        const unsigned int succ = m_dic.getSuccByCode(iNode, code);
+        if (succ)
+        {
+            ioPartialWord.addLeftFromBoard(m_tilesMx[iRow][iCol]);
+            gaddagGoOn(iRack, ioPartialWord, oResults, succ,
+                       iRow, iCol, iAnchor, iLastAnchor);
+            ioPartialWord.removeLeft();
+        }
+        return;
+    }
+
+    // Optimization: avoid entering the for loop if no tile can match
+    if (m_crossMx[iRow][iCol].isNone())
+        return;
+
+    bool hasJokerInRack = iRack.contains(Tile::Joker());
+    for (unsigned int succ = m_dic.getSucc(iNode); succ; succ = m_dic.getNext(succ))
+    {
+        if (m_dic.getCode(succ) == DIC_GADDAG_SEPARATOR)
+            continue;
+        const Tile &l = m_dic.getTileFromCode(m_dic.getCode(succ));
+        if (m_crossMx[iRow][iCol].check(l))
         {
-            if ((wint_t)m_dic.getChar(succ) == upperChar)
+            if (iRack.contains(l))
+            {
+                iRack.remove(l);
+                ioPartialWord.addLeftFromRack(l, false);
+                gaddagGoOn(iRack, ioPartialWord, oResults, succ,
+                           iRow, iCol, iAnchor, iLastAnchor);
+                ioPartialWord.removeLeft();
+                iRack.add(l);
+            }
+            if (hasJokerInRack)
+            {
+                iRack.remove(Tile::Joker());
+                ioPartialWord.addLeftFromRack(l, true);
+                gaddagGoOn(iRack, ioPartialWord, oResults, succ,
+                           iRow, iCol, iAnchor, iLastAnchor);
+                ioPartialWord.removeLeft();
+                iRack.add(Tile::Joker());
+            }
+        }
+    }
+}
+
+
+void BoardSearch::gaddagGoOn(Rack &iRack, Round &ioPartialWord,
+                             Results &oResults, unsigned int iNode,
+                             int iRow, int iCol, int iAnchor,
+                             int iLastAnchor) const
+{
+    ioPartialWord.accessCoord().setCol(iCol);
+
+    // A tile on the left must be part of the word
+    if (!m_tilesMx[iRow][iCol - 1].isEmpty())
+    {
+        gaddagLeft(iRack, ioPartialWord, oResults, iNode,
+                   iRow, iCol - 1, iAnchor, iLastAnchor);
+    }
+    else
+    {
+        // The left part of the word is complete: switch to the right part
+        const unsigned int sep = m_dic.getSuccByCode(iNode, DIC_GADDAG_SEPARATOR);
+        if (sep)
+        {
+            if (m_dic.isEndOfWord(sep) && m_tilesMx[iRow][iAnchor + 1].isEmpty())
+            {
+                evalMove(oResults, ioPartialWord);
+            }
+            gaddagRight(iRack, ioPartialWord, oResults, sep,
+                        iRow, iAnchor + 1);
+        }
+
+        // Try to extend the left part, without reaching the previous anchor
+        if (iCol - 1 > iLastAnchor && iRack.getNbTiles() > 0)
+        {
+            gaddagLeft(iRack, ioPartialWord, oResults, iNode,
+                       iRow, iCol - 1, iAnchor, iLastAnchor);
+        }
+    }
+
+    ioPartialWord.accessCoord().setCol(iCol + 1);
+}
+
+
+void BoardSearch::gaddagRight(Rack &iRack, Round &ioPartialWord,
+                              Results &oResults, unsigned int iNode,
+                              int iRow, int iCol) const
+{
+    if (!m_tilesMx[iRow][iCol].isEmpty())
+    {
+        const unsigned int code = m_tilesMx[iRow][iCol].toCode();
+        const unsigned int succ = m_dic.getSuccByCode(iNode, code);
+        if (succ)
+        {
+            ioPartialWord.addRightFromBoard(m_tilesMx[iRow][iCol]);
+            if (m_dic.isEndOfWord(succ) && m_tilesMx[iRow][iCol + 1].isEmpty())
+            {
+                evalMove(oResults, ioPartialWord);
+            }
+            gaddagRight(iRack, ioPartialWord, oResults, succ, iRow, iCol + 1);
+            ioPartialWord.removeRight();
+        }
+        return;
+    }
+
+    // Optimization: avoid entering the for loop if no tile can match
+    if (m_crossMx[iRow][iCol].isNone())
+        return;
+
+    bool hasJokerInRack = iRack.contains(Tile::Joker());
+    for (unsigned int succ = m_dic.getSucc(iNode); succ; succ = m_dic.getNext(succ))
+    {
+        const Tile &l = m_dic.getTileFromCode(m_dic.getCode(succ));
+        if (m_crossMx[iRow][iCol].check(l))
+        {
+            const bool isWord = m_dic.isEndOfWord(succ) &&
+                m_tilesMx[iRow][iCol + 1].isEmpty();
+            if (iRack.contains(l))
             {
-                ioPartialWord.addRightFromBoard(l);
-                extendRight(iRack, ioPartialWord,
-                            oResults, succ, iRow, iCol + 1, iAnchor);
+                iRack.remove(l);
+                ioPartialWord.addRightFromRack(l, false);
+                if (isWord)
+                    evalMove(oResults, ioPartialWord);
+                gaddagRight(iRack, ioPartialWord, oResults, succ,
+                            iRow, iCol + 1);
                 ioPartialWord.removeRight();
-                // The letter will be present only once in the dictionary,
-                // so we can stop looping
-                break;
+                iRack.add(l);
+            }
+            if (hasJokerInRack)
+            {
+                iRack.remove(Tile::Joker());
+                ioPartialWord.addRightFromRack(l, true);
+                if (isWord)
+                    evalMove(oResults, ioPartialWord);
+                gaddagRight(iRack, ioPartialWord, oResults, succ,
+                            iRow, iCol + 1);
+                ioPartialWord.removeRight();
+                iRack.add(Tile::Joker());
             }
         }
     }
@@ -251,7 +449,7 @@ void BoardSearch::evalMove(Results &oResults, Round &iWord) const
     {
         if (!m_tilesMx[row][col+i].isEmpty())
         {
-            if (!m_jokerMx[row][col+i])
+            if (!m_tilesMx[row][col+i].isJoker())
                 pts += iWord.getTile(i).getPoints();
         }
         else
@@ -278,11 +476,12 @@ void BoardSearch::evalMove(Results &oResults, Round &iWord) const
         return;
 
     pts = ptscross + pts * wordmul;
-    if (fromrack == m_params.getLettersToPlay())
-    {
+    // The partial word is reused for all the moves, so the flag must
+    // always be set (it would be stale otherwise)
+    const bool bonus = (fromrack == m_params.getLettersToPlay());
+    if (bonus)
         pts += m_params.getBonusPoints();
-        iWord.setBonus(true);
-    }
+    iWord.setBonus(bonus);
     iWord.setPoints(pts);
 
     if (iWord.getCoord().getDir() == Coord::VERTICAL)
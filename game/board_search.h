@@ -22,7 +22,7 @@
 #define BOARD_SEARCH_H_
 
 #include "coord.h"
-#include "matrix.h"
+#include "board_matrix.h"
 
 class Dictionary;
 class GameParams;
@@ -33,26 +33,38 @@ class Round;
 class Cross;
 
 
+/**
+ * Search of all the possible moves on the board, in one direction.
+ * When the dictionary contains a GADDAG, the moves are generated from
+ * each anchor in both directions (as described by Gordon), otherwise
+ * the Appel & Jacobson algorithm is used on the DAWG.
+ */
 class BoardSearch
 {
 public:
     BoardSearch(const Dictionary &iDic,
                 const GameParams &iParams,
-                const Matrix<Tile> &iTilesMx,
-                const Matrix<Cross> &iCrossMx,
-                const Matrix<int> &iPointsMx,
-                const Matrix<bool> &iJokerMx,
+                const BoardMatrix<Tile> &iTilesMx,
+                const BoardMatrix<Cross> &iCrossMx,
+                const BoardMatrix<int> &iPointsMx,
                 bool isFirstTurn = false);
 
-    void search(Rack &iRack, Results &oResults, Coord::Direction iDir) const;
+    /**
+     * Give to oResults all the moves found in the rows [iFirstRow, iLastRow]
+     * of the matrices (i.e. the columns of the board for a vertical search).
+     * On the first turn, only the center row of the board is searched.
+     * The search only modifies its arguments (the rack is restored at the
+     * end), so several searches can be performed in parallel.
+     */
+    void search(Rack &iRack, Results &oResults, Coord::Direction iDir,
+                int iFirstRow, int iLastRow) const;
 
 private:
     const Dictionary &m_dic;
     const GameParams &m_params;
-    const Matrix<Tile> &m_tilesMx;
-    const Matrix<Cross> &m_crossMx;
-    const Matrix<int> &m_pointsMx;
-    const Matrix<bool> &m_jokerMx;
+    const BoardMatrix<Tile> &m_tilesMx;
+    const BoardMatrix<Cross> &m_crossMx;
+    const BoardMatrix<int> &m_pointsMx;
     const bool m_firstTurn;
 
     void leftPart(Rack &iRack, Round &ioPartialWord,
@@ -63,6 +75,32 @@ private:
                      Results &oResults, unsigned int iNode,
                      int iRow, int iCol, int iAnchor) const;
 
+    /// Search using the GADDAG, when it is available
+    void searchGaddag(Rack &iRack, Results &oResults,
+                      Coord::Direction iDir,
+                      int iFirstRow, int iLastRow) const;
+
+    /**
+     * Place a letter at column iCol (on the left of the anchor, or on
+     * the anchor itself), following the GADDAG from iNode
+     */
+    void gaddagLeft(Rack &iRack, Round &ioPartialWord,
+                    Results &oResults, unsigned int iNode,
+                    int iRow, int iCol, int iAnchor, int iLastAnchor) const;
+
+    /// Continue after a letter was placed at column iCol by gaddagLeft()
+    void gaddagGoOn(Rack &iRack, Round &ioPartialWord,
+                    Results &oResults, unsigned int iNode,
+                    int iRow, int iCol, int iAnchor, int iLastAnchor) const;
+
+    /**
+     * Place a letter at column iCol (on the right of the anchor),
+     * following the GADDAG from iNode (which is after the separator)
+     */
+    void gaddagRight(Rack &iRack, Round &ioPartialWord,
+                     Results &oResults, unsigned int iNode,
+                     int iRow, int iCol) const;
+
     void evalMove(Results &oResults, Round &iWord) const;
 };
 
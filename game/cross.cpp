@@ -23,7 +23,7 @@
 #include <cstdio>
 #include "cross.h"
 
-#define CROSS_MASK 0xFFFFFFFF
+#define CROSS_MASK (~(uint64_t)0)
 
 
 INIT_LOGGER(game, Cross);
@@ -50,8 +50,8 @@ bool Cross::isAny() const
 
 string Cross::getHexContent() const
 {
-    char buff[10];
-    sprintf(buff,"%08x",m_mask);
+    char buff[20];
+    sprintf(buff, "%016llx", (unsigned long long)m_mask);
     string s(buff);
     return s;
 }
@@ -59,13 +59,21 @@ string Cross::getHexContent() const
 
 bool Cross::check(const Tile& iTile) const
 {
-    return m_mask & (1 << iTile.toCode()) || (iTile.isPureJoker() && m_mask);
+    return (m_mask & ((uint64_t)1 << iTile.toCode())) ||
+        (iTile.isPureJoker() && m_mask);
 }
 
 
-void Cross::insert(const Tile& iTile)
+unsigned int Cross::count() const
 {
-    m_mask |= (1 << iTile.toCode());
+#if defined(__GNUC__)
+    return __builtin_popcountll(m_mask);
+#else
+    unsigned int nb = 0;
+    for (uint64_t mask = m_mask; mask; mask &= mask - 1)
+        ++nb;
+    return nb;
+#endif
 }
 
 
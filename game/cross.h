@@ -23,6 +23,7 @@
 #define CROSS_H_
 
 #include <set>
+#include <stdint.h>
 #include "tile.h"
 #include "logging.h"
 
@@ -33,7 +34,12 @@ using namespace std;
  *
  *************************/
 
-// TODO: implement using the bitset class
+/**
+ * Set of the tiles which can be played on a square of the board, given
+ * the tiles around it in the other direction. It is represented by a mask
+ * of 64 bits, indexed by tile codes (the codes of the dictionary have
+ * 6 bits), so that the set operations work on the whole set at once.
+ */
 class Cross
 {
     DEFINE_LOGGER();
@@ -48,16 +54,29 @@ public:
 
     bool check(const Tile& iTile) const;
 
+    /**
+     * Return true if at least one of the codes of the given mask
+     * (bit i set for the code i) is in the set
+     */
+    bool checkMask(uint64_t iCodesMask) const { return (m_mask & iCodesMask) != 0; }
+
+    /// Number of codes in the set
+    unsigned int count() const;
+
     bool operator==(const Cross &iOther) const;
     bool operator!=(const Cross &iOther) const { return !(*this == iOther); }
 
     // Standard set methods (almost)
-    void insert(const Tile& iTile);
+    void insert(const Tile& iTile) { m_mask |= (uint64_t)1 << iTile.toCode(); }
+
+    /// Intersection and union with another set
+    Cross & operator&=(const Cross &iOther) { m_mask &= iOther.m_mask; return *this; }
+    Cross & operator|=(const Cross &iOther) { m_mask |= iOther.m_mask; return *this; }
 
     string getHexContent() const;
 private:
     /// Mask indicating which tiles are accepted for the cross check
-    unsigned int m_mask;
+    uint64_t m_mask;
 };
 
 #endif
@@ -29,7 +29,8 @@ INIT_LOGGER(game, Rack);
 
 
 Rack::Rack()
-    : m_tiles(Dictionary::GetDic().getTileNumber() + 1, 0), m_nbTiles(0)
+    : m_tiles(Dictionary::GetDic().getTileNumber() + 1, 0), m_nbTiles(0),
+    m_codesMask(0)
 {
 }
 
@@ -38,7 +39,8 @@ void Rack::remove(const Tile &t)
 {
     ASSERT(count(t),
            "The rack does not contain the letter " + lfw(t.getDisplayStr()));
-    m_tiles[t.toCode()]--;
+    if (--m_tiles[t.toCode()] == 0)
+        m_codesMask &= ~((uint64_t)1 << t.toCode());
     m_nbTiles--;
 }
 
@@ -50,6 +52,7 @@ void Rack::clear()
         m_tiles[i] = 0;
     }
     m_nbTiles = 0;
+    m_codesMask = 0;
 }
 
 
@@ -64,6 +67,14 @@ void Rack::getTiles(vector<Tile> &oTiles) const
 }
 
 
+uint64_t Rack::getCodesMask() const
+{
+    if (contains(Tile::Joker()))
+        return ~(uint64_t)0;
+    return m_codesMask;
+}
+
+
 wstring Rack::toString() const
 {
     wstring rs;
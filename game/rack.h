@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <string>
+#include <stdint.h>
 
 #include "tile.h"
 #include "logging.h"
@@ -47,11 +48,23 @@ public:
     unsigned count(const Tile &t) const { return m_tiles[t.toCode()]; }
     bool contains(const Tile &t) const { return count(t); }
 
-    void add(const Tile &t)     { m_tiles[t.toCode()]++; m_nbTiles++; }
+    void add(const Tile &t)
+    {
+        m_tiles[t.toCode()]++;
+        m_nbTiles++;
+        m_codesMask |= (uint64_t)1 << t.toCode();
+    }
     void remove(const Tile &t);
     void clear();
     void getTiles(vector<Tile> &oTiles) const;
 
+    /**
+     * Return the codes of the letters which can be played from the rack,
+     * as a bit mask (bit i is set for the code i). All the bits are set
+     * if the rack contains a joker, since it can replace any letter.
+     */
+    uint64_t getCodesMask() const;
+
     wstring toString() const;
 
     bool operator==(const Rack &iOther) const;
@@ -60,6 +73,8 @@ private:
     /// Vector indexed by tile codes, containing the number of tiles
     vector<unsigned int> m_tiles;
     unsigned m_nbTiles;
+    /// Bit mask of the codes of the tiles in the rack
+    uint64_t m_codesMask;
 };
 
 #endif
@@ -125,7 +125,7 @@ void BestResults::search(const Dictionary &iDic, const Board &iBoard,
     if (iFirstWord)
         iBoard.searchFirst(iDic, iRack, *this);
     else
-        iBoard.search(iDic, iRack, *this);
+        iBoard.search(iDic, iRack, *this, m_nbThreads);
 
     sort();
 }
@@ -154,6 +154,12 @@ void BestResults::clear()
 }
 
 
+Results * BestResults::createSimilar() const
+{
+    return new BestResults;
+}
+
+
 
 PercentResults::PercentResults(float iPercent)
     : m_percent(iPercent), m_bestScore(0), m_minScore(0)
@@ -182,7 +188,7 @@ void PercentResults::search(const Dictionary &iDic, const Board &iBoard,
     if (iFirstWord)
         iBoard.searchFirst(iDic, iRack, *this);
     else
-        iBoard.search(iDic, iRack, *this);
+        iBoard.search(iDic, iRack, *this, m_nbThreads);
 
     if (m_rounds.empty())
         return;
@@ -234,6 +240,14 @@ void PercentResults::clear()
 }
 
 
+Results * PercentResults::createSimilar() const
+{
+    // The best score of a line is not higher than the best score of the
+    // board, so the rounds ignored in the line are ignored on the board
+    return new PercentResults(m_percent);
+}
+
+
 
 LimitResults::LimitResults(int iLimit)
     : m_limit(iLimit), m_total(0), m_minScore(-1)
@@ -249,7 +263,7 @@ void LimitResults::search(const Dictionary &iDic, const Board &iBoard,
     if (iFirstWord)
         iBoard.searchFirst(iDic, iRack, *this);
     else
-        iBoard.search(iDic, iRack, *this);
+        iBoard.search(iDic, iRack, *this, m_nbThreads);
 
     if (m_rounds.empty())
         return;
@@ -272,8 +286,10 @@ void LimitResults::add(const Round &iRound)
         return;
     }
 
-    // Ignore too low scores
-    if (m_minScore >= iRound.getPoints())
+    // Ignore too low scores. The rounds with the minimum score are still
+    // kept, so that the results do not depend on the order in which the
+    // rounds are found (it differs between the DAWG and the GADDAG)
+    if (m_minScore > iRound.getPoints())
         return;
 
     // Add the round
@@ -308,6 +324,14 @@ void LimitResults::clear()
 }
 
 
+Results * LimitResults::createSimilar() const
+{
+    // The rounds ignored in a line are not among the best rounds of the
+    // line, so they are not among the best rounds of the board either
+    return new LimitResults(m_limit);
+}
+
+
 
 MasterResults::MasterResults(const Bag &iBag)
     : m_bag(iBag)
@@ -319,6 +343,7 @@ void MasterResults::search(const Dictionary &iDic, const Board &iBoard,
                            const Rack &iRack, bool iFirstWord)
 {
     // Perform the search of the best results
+    m_bestResults.setNbThreads(m_nbThreads);
     m_bestResults.search(iDic, iBoard, iRack, iFirstWord);
 
     // If the search yields no result, there is nothing else to do
@@ -345,3 +370,10 @@ void MasterResults::clear()
 }
 
 
+Results * MasterResults::createSimilar() const
+{
+    // The rounds are given to m_bestResults
+    return m_bestResults.createSimilar();
+}
+
+
@@ -50,6 +50,7 @@ class Results
 {
     DEFINE_LOGGER();
 public:
+    Results() : m_nbThreads(1) {}
     virtual ~Results() {}
     unsigned int size() const { return m_rounds.size(); }
     const Round & get(unsigned int) const;
@@ -69,8 +70,23 @@ public:
     /** Clear the stored rounds, and get ready for a new search */
     virtual void clear() = 0;
 
+    /**
+     * Return new empty results, whose add() method keeps the same rounds
+     * as the one of this object. The parallel search uses them to select
+     * the rounds of each line of the board. The caller takes ownership.
+     */
+    virtual Results * createSimilar() const = 0;
+
+    /**
+     * Set the number of threads used by the search (1 by default, 0 means
+     * one per processor). The results are the same in all cases.
+     */
+    void setNbThreads(unsigned int iNbThreads) { m_nbThreads = iNbThreads; }
+
 protected:
     vector<Round> m_rounds;
+    /// Number of threads used by the search (see Board::search())
+    unsigned int m_nbThreads;
     void sort();
 };
 
@@ -87,6 +103,7 @@ public:
                         const Rack &iRack, bool iFirstWord);
     virtual void clear();
     virtual void add(const Round &iRound);
+    virtual Results * createSimilar() const;
 
 private:
     int m_bestScore;
@@ -108,6 +125,7 @@ public:
                         const Rack &iRack, bool iFirstWord);
     virtual void clear();
     virtual void add(const Round &iRound);
+    virtual Results * createSimilar() const;
 
 private:
     const float m_percent;
@@ -129,6 +147,7 @@ public:
                         const Rack &iRack, bool iFirstWord);
     virtual void clear();
     virtual void add(const Round &iRound);
+    virtual Results * createSimilar() const;
 
     void setLimit(int iNewLimit) { m_limit = iNewLimit; }
 
@@ -155,6 +174,7 @@ public:
                         const Rack &iRack, bool iFirstWord);
     virtual void clear();
     virtual void add(const Round &iRound);
+    virtual Results * createSimilar() const;
 
 private:
     const Bag &m_bag;
@@ -115,6 +115,33 @@ void Round::removeRight()
 }
 
 
+void Round::addLeftFromBoard(const Tile &iTile)
+{
+    // See addRightFromBoard()
+    m_word.insert(m_word.begin(), iTile.toUpper());
+    m_rackOrigin.insert(m_rackOrigin.begin(), false);
+}
+
+
+void Round::addLeftFromRack(const Tile &iTile, bool iJoker)
+{
+    if (iJoker)
+        m_word.insert(m_word.begin(), iTile.toLower());
+    else
+        m_word.insert(m_word.begin(), iTile);
+    m_rackOrigin.insert(m_rackOrigin.begin(), true);
+}
+
+
+void Round::removeLeft()
+{
+    ASSERT(!m_word.empty() && !m_rackOrigin.empty(),
+           "Trying to remove tiles that were never added");
+    m_word.erase(m_word.begin());
+    m_rackOrigin.erase(m_rackOrigin.begin());
+}
+
+
 wstring Round::getWord() const
 {
     wstring s;
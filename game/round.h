@@ -50,6 +50,11 @@ public:
     void addRightFromRack(const Tile &iTile, bool iJoker);
     void removeRight();
 
+    /// Same as above, but on the left side of the word
+    void addLeftFromBoard(const Tile &iTile);
+    void addLeftFromRack(const Tile &iTile, bool iJoker);
+    void removeLeft();
+
     /*************************
      * General setters
      *************************/
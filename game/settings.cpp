@@ -196,6 +196,11 @@ Settings::Settings()
     m_conf = new Config;
 
     // ============== General options ==============
+    Setting &general = m_conf->getRoot().add("general", Setting::TypeGroup);
+
+    // Number of threads used to search the moves on the board
+    // (0 means one per processor)
+    general.add("search-threads", Setting::TypeInt) = 1;
 
     // ============== Training mode options ==============
     Setting &training = m_conf->getRoot().add("training", Setting::TypeGroup);
@@ -270,6 +275,7 @@ Settings::Settings()
         // one by one...
         Config tmpConf;
         tmpConf.readFile(m_fileName.c_str());
+        copySetting<int>(tmpConf, *m_conf, "general.search-threads");
         copySetting<int>(tmpConf, *m_conf, "training.search-limit");
         copySetting<int>(tmpConf, *m_conf, "duplicate.solo-players");
         copySetting<int>(tmpConf, *m_conf, "duplicate.solo-value");
@@ -337,6 +343,9 @@ bool Settings::getBool(const string &iName) const
     }
 #else
     // Dummy implementation
+    map<string, int>::const_iterator it = m_values.find(iName);
+    if (it != m_values.end())
+        return it->second;
     return true;
 #endif
 }
@@ -361,7 +370,12 @@ int Settings::getInt(const string &iName) const
     }
 #else
     // Dummy implementation
-    if (iName == "training.search-limit")
+    map<string, int>::const_iterator it = m_values.find(iName);
+    if (it != m_values.end())
+        return it->second;
+    if (iName == "general.search-threads")
+        return 1;
+    else if (iName == "training.search-limit")
         return 100;
     else if (iName == "duplicate.solo-players")
         return 16;
@@ -398,6 +412,8 @@ void Settings::setValue(const string &iName, T iValue)
         throw GameException("No such option: " + iName);
 #endif
     }
+#else
+    m_values[iName] = iValue;
 #endif
 }
 
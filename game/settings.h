@@ -78,6 +78,12 @@ private:
 
     libconfig::Config *m_conf;
 
+    /**
+     * Values given to setBool() and setInt() when Eliot is compiled
+     * without libconfig (they are lost at the end of the program)
+     */
+    map<string, int> m_values;
+
     template<class T>
     void setValue(const string &iName, T iValue);
 };
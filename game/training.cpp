@@ -157,6 +157,7 @@ void Training::search()
     const Rack &rack = getHistory().getCurrentRack().getRack();
     int limit = Settings::Instance().getInt("training.search-limit");
     m_results.setLimit(limit);
+    m_results.setNbThreads(Settings::Instance().getInt("general.search-threads"));
     m_results.search(getDic(), getBoard(), rack, getHistory().beforeFirstRound());
 }
 
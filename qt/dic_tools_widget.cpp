@@ -36,6 +36,7 @@
 #include "validator_factory.h"
 #include "qtcommon.h"
 #include "dic.h"
+#include "regexp_cursor.h"
 #include "header.h"
 #include "listdic.h"
 #include "encoding.h"
@@ -48,7 +49,7 @@ INIT_LOGGER(qt, DicToolsWidget);
 
 
 DicToolsWidget::DicToolsWidget(QWidget *parent)
-    : QWidget(parent), m_dic(NULL)
+    : QWidget(parent), m_dic(NULL), m_regexpCursor(NULL)
 {
     setupUi(this);
 
@@ -60,6 +61,7 @@ DicToolsWidget::DicToolsWidget(QWidget *parent)
     greenPalette.setColor(QPalette::Foreground, Qt::darkGreen);
 
     labelLimitReached->hide();
+    buttonMoreRegexp->hide();
 
     // Create connections
     QObject::connect(lineEditCheck, SIGNAL(textChanged(const QString&)),
@@ -76,6 +78,8 @@ DicToolsWidget::DicToolsWidget(QWidget *parent)
                      this, SLOT(refreshRegexp()));
     QObject::connect(buttonSearchRegexp, SIGNAL(clicked()),
                      this, SLOT(refreshRegexp()));
+    QObject::connect(buttonMoreRegexp, SIGNAL(clicked()),
+                     this, SLOT(fetchMoreRegexp()));
     QObject::connect(buttonSaveRegexp, SIGNAL(clicked()),
                      this, SLOT(saveRegexpResults()));
     QObject::connect(buttonSaveWords, SIGNAL(clicked()),
@@ -117,10 +121,19 @@ DicToolsWidget::DicToolsWidget(QWidget *parent)
 }
 
 
+DicToolsWidget::~DicToolsWidget()
+{
+    delete m_regexpCursor;
+}
+
+
 void DicToolsWidget::setDic(const Dictionary *iDic)
 {
     if (m_dic != iDic)
     {
+        // The cursor must not survive its dictionary
+        delete m_regexpCursor;
+        m_regexpCursor = NULL;
         m_dic = iDic;
         // Reset the letters
         lineEditCheck->clear();
@@ -258,12 +271,15 @@ void DicToolsWidget::refreshRegexp()
     QStandardItemModel *model = m_regexpModel;
     QLineEdit *rack = lineEditRegexp;
 
+    delete m_regexpCursor;
+    m_regexpCursor = NULL;
     model->removeRows(0, model->rowCount());
     if (m_dic == NULL)
     {
         model->setHeaderData(0, Qt::Horizontal,
                                _q("Please select a dictionary"),
                                Qt::DisplayRole);
+        fetchMoreRegexp();
         return;
     }
 
@@ -277,37 +293,47 @@ void DicToolsWidget::refreshRegexp()
     {
         unsigned lmin = spinBoxMinLength->value();
         unsigned lmax = spinBoxMaxLength->value();
-        // FIXME: this value should not be hardcoded,
-        // or a warning should appear when it is reached
-        unsigned limit = 1000;
-        vector<wstring> wordList;
-        bool res = true;
-        int rowNum = 0;
         try
         {
-            res = m_dic->searchRegExp(input, wordList, lmin, lmax, limit);
+            m_regexpCursor = new RegexpCursor(*m_dic, input, lmin, lmax);
         }
         catch (InvalidRegexpException &e)
         {
-            model->insertRow(rowNum);
-            model->setData(model->index(rowNum, 0),
+            model->insertRow(0);
+            model->setData(model->index(0, 0),
                            _q("Invalid regular expression: %1").arg(qfl(e.what())));
-            model->setData(model->index(rowNum, 0),
+            model->setData(model->index(0, 0),
                            QBrush(Qt::red), Qt::ForegroundRole);
         }
+    }
+    fetchMoreRegexp();
+}
 
-        vector<wstring>::const_iterator it;
+
+void DicToolsWidget::fetchMoreRegexp()
+{
+    if (m_regexpCursor != NULL)
+    {
+        // The words are only retrieved when they are displayed, so the
+        // search doesn't depend on the number of results
+        static const unsigned int kPageSize = 1000;
+        vector<wdstring> wordList;
+        m_regexpCursor->getNextWords(wordList, kPageSize);
+
+        QStandardItemModel *model = m_regexpModel;
+        int rowNum = model->rowCount();
+        vector<wdstring>::const_iterator it;
         for (it = wordList.begin(); it != wordList.end(); it++)
         {
             model->insertRow(rowNum);
             model->setData(model->index(rowNum, 0), qfw(*it));
             ++rowNum;
         }
-        if (res)
-            labelLimitReached->hide();
-        else
-            labelLimitReached->show();
     }
+
+    const bool hasMore = m_regexpCursor != NULL && !m_regexpCursor->isFinished();
+    labelLimitReached->setVisible(hasMore);
+    buttonMoreRegexp->setVisible(hasMore);
 }
 
 
@@ -325,7 +351,8 @@ void DicToolsWidget::saveRegexpResults()
         vector<wstring> wordList;
         try
         {
-            m_dic->searchRegExp(input, wordList, lmin, lmax, 0);
+            // Use all the processors, the results can be numerous
+            m_dic->searchRegExp(input, wordList, lmin, lmax, 0, 0);
         }
         catch (InvalidRegexpException &e)
         {
@@ -31,6 +31,7 @@
 class QStandardItemModel;
 class QString;
 class Dictionary;
+class RegexpCursor;
 class CustomPopup;
 
 class DicToolsWidget: public QWidget, private Ui::DicToolsWidget
@@ -40,6 +41,7 @@ class DicToolsWidget: public QWidget, private Ui::DicToolsWidget
 
 public:
     explicit DicToolsWidget(QWidget *parent = 0);
+    virtual ~DicToolsWidget();
 
 public slots:
     void setDic(const Dictionary *iDic);
@@ -56,6 +58,11 @@ private:
     QStandardItemModel *m_plus1Model;
     /// Model of the tree view for the "regexp" search
     QStandardItemModel *m_regexpModel;
+    /**
+     * Cursor on the results of the "regexp" search, giving the next
+     * words on demand (NULL if there is no search)
+     */
+    RegexpCursor *m_regexpCursor;
     /// Model of the tree view for the dictionary letters
     QStandardItemModel *m_dicInfoModel;
 
@@ -85,6 +92,8 @@ private slots:
     void refreshPlus1();
     /// Force synchronizing the model with the "regexp" results
     void refreshRegexp();
+    /// Append the next page of "regexp" results to the model
+    void fetchMoreRegexp();
     /// Force synchronizing the model with the dictionary letters
     void refreshDicInfo();
     /// Save the words of the dictionary to a file
@@ -23,6 +23,19 @@ my @eliottxt_array = (
     "$root_path/linux/utils/eliottxt",
     "$root_path/win32/utils/eliottxt.exe"
     );
+# Places where to search for the dictionary tools
+my @compdic_array = (
+    "$root_path/dic/compdic",
+    "$root_path/build/dic/compdic",
+    "$root_path/linux/dic/compdic",
+    "$root_path/win32/dic/compdic.exe"
+    );
+my @listdic_array = (
+    "$root_path/dic/listdic",
+    "$root_path/build/dic/listdic",
+    "$root_path/linux/dic/listdic",
+    "$root_path/win32/dic/listdic.exe"
+    );
 
 # Change to the test/ directory, because some scenarii expect
 # to find saved games in there
@@ -70,10 +83,73 @@ if (not -x $eliottxt)
     die "Cannot find the text interface executable in [".join(", ", @eliottxt_array)."]";
 }
 
+# Find compdic and listdic
+my $compdic = "";
+foreach my $compdic_file (@compdic_array)
+{
+    if (-f $compdic_file)
+    {
+        $compdic = $compdic_file;
+        last;
+    }
+}
+if (not -x $compdic)
+{
+    die "Cannot find the compdic executable in [".join(", ", @compdic_array)."]";
+}
+my $listdic = "";
+foreach my $listdic_file (@listdic_array)
+{
+    if (-f $listdic_file)
+    {
+        $listdic = $listdic_file;
+        last;
+    }
+}
+if (not -x $listdic)
+{
+    die "Cannot find the listdic executable in [".join(", ", @listdic_array)."]";
+}
+
+
+# The scenarios are played a second time with a copy of the dictionary
+# containing a GADDAG and the child masks, to check that the search of the
+# moves with the GADDAG (and the indexed lookups) gives exactly the same
+# results as with the DAWG
+system("mkdir -p $tmp_dir");
+my $ods_gaddag = "$tmp_dir/ods5-gaddag.dawg";
+my $header = `$listdic -e -d $ods`;
+my ($dic_name) = $header =~ /^Dictionary name: (.*)$/m;
+system("$listdic -l -d $ods > $tmp_dir/letters.txt") == 0
+    or die "Cannot extract the letters of $ods";
+system("$listdic -w -d $ods > $tmp_dir/words.txt") == 0
+    or die "Cannot extract the words of $ods";
+system("$compdic -g -m -d '$dic_name' -l $tmp_dir/letters.txt " .
+       "-i $tmp_dir/words.txt -o $ods_gaddag > /dev/null") == 0
+    or die "Cannot build the GADDAG dictionary $ods_gaddag";
+
+# Small dictionary of the tests, with word counts and an anagram index,
+# for the scenarios needing them (third column of the driver file)
+my $test_dic = "$tmp_dir/test.dawg";
+my $test_gaddag = "$tmp_dir/test-gaddag.dawg";
+system("$compdic -w -a -d 'Test' -l dic/letters.txt " .
+       "-i dic/words.txt -o $test_dic > /dev/null") == 0
+    or die "Cannot build the test dictionary $test_dic";
+system("$compdic -g -m -w -a -d 'Test' -l dic/letters.txt " .
+       "-i dic/words.txt -o $test_gaddag > /dev/null") == 0
+    or die "Cannot build the GADDAG test dictionary $test_gaddag";
+
+my %dictionaries = (
+    "ods5" => [[$ods, ""], [$ods_gaddag, ".gaddag"]],
+    "test" => [[$test_dic, ""], [$test_gaddag, ".gaddag"]]
+    );
+
 
-# Fill a map of (scenario --> randseed) from the driver file.
+# Fill a map of (scenario --> randseed) and a map of (scenario --> dictionary)
+# from the driver file.
 # Also fill the list of scenarios in the order of the driver file.
 my %scenario_map;
+my %scenario_dic_map;
 my @all_scenarios;
 open(DRIVER, $driver_file) or die "Cannot open the scenario list: $!";
 while(<DRIVER>)
@@ -81,9 +157,12 @@ while(<DRIVER>)
     chomp;
     my $line = $_;
     $line =~ s/#.*//;
-    if ($line =~ /^\s*(\w+\/\w+)\s+(\d+)\s*$/)
+    if ($line =~ /^\s*(\w+\/\w+)\s+(\d+)(?:\s+(\w+))?\s*$/)
     {
+        my $dic = defined($3) ? $3 : "ods5";
+        die "Unknown dictionary $dic for scenario $1" if not exists $dictionaries{$dic};
         $scenario_map{$1} = $2;
+        $scenario_dic_map{$1} = $dic;
         push(@all_scenarios, $1);
     }
 }
@@ -115,8 +194,8 @@ foreach my $scenario (@scenarios_to_play)
     print "Scenario: $scenario\n";
     my $input_file = $scenario . $input_ext;
     my $ref_file   = $scenario . $ref_ext;
-    my $run_file   = $scenario . $run_ext;
     my $randseed   = $scenario_map{$scenario};
+    my $dic_key    = $scenario_dic_map{$scenario} || "ods5";
 
     # Check that the needed files exist
     if (not -f $input_file)
@@ -132,30 +211,37 @@ foreach my $scenario (@scenarios_to_play)
         next;
     }
 
-    # OK, let's do the actual stuff
-    unlink $run_file;
-    my $rc = `$eliottxt $ods $randseed < $input_file > $run_file 2>&1`;
-    if ($rc ne "")
+    foreach my $dictionary (@{$dictionaries{$dic_key}})
     {
-        print "--> Error: execution of scenario failed (return value: $rc)\n";
-        push(@errors, $scenario);
-        next;
-    }
+        my ($dic, $suffix) = @$dictionary;
+        my $run_file = $scenario . $suffix . $run_ext;
+        my $name = $scenario . $suffix;
 
-    # Create temporary copies of the files, without comments
-    my $tmp_ref_file = "$tmp_dir/$ref_file";
-    my $tmp_run_file = "$tmp_dir/$run_file";
-    system("mkdir -p `dirname $tmp_ref_file`");
-    system("cat $ref_file | egrep -v '^#' | egrep -v '^\\w+> #' > $tmp_ref_file");
-    system("cat $run_file | egrep -v '^#' | egrep -v '^\\w+> #' > $tmp_run_file");
+        # OK, let's do the actual stuff
+        unlink $run_file;
+        my $rc = `$eliottxt $dic $randseed < $input_file > $run_file 2>&1`;
+        if ($rc ne "")
+        {
+            print "--> Error: execution of scenario failed with $dic (return value: $rc)\n";
+            push(@errors, $name);
+            next;
+        }
 
-    # Is the output file different from the reference file?
-    my $diff = `diff $tmp_ref_file $tmp_run_file`;
-    if ($diff ne "")
-    {
-        print "--> Error: found differences:\n";
-        print $diff;
-        push(@errors, $scenario);
+        # Create temporary copies of the files, without comments
+        my $tmp_ref_file = "$tmp_dir/$ref_file";
+        my $tmp_run_file = "$tmp_dir/$run_file";
+        system("mkdir -p `dirname $tmp_ref_file`");
+        system("cat $ref_file | egrep -v '^#' | egrep -v '^\\w+> #' > $tmp_ref_file");
+        system("cat $run_file | egrep -v '^#' | egrep -v '^\\w+> #' > $tmp_run_file");
+
+        # Is the output file different from the reference file?
+        my $diff = `diff $tmp_ref_file $tmp_run_file`;
+        if ($diff ne "")
+        {
+            print "--> Error: found differences with $dic:\n";
+            print $diff;
+            push(@errors, $name);
+        }
     }
 }
 
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <locale.h>
 #include <wctype.h>
+#include <algorithm>
 #if HAVE_READLINE_READLINE_H
 #   include <stdio.h>
 #   include <readline/readline.h>
@@ -38,6 +39,7 @@
 #endif
 
 #include "dic.h"
+#include "regexp_cursor.h"
 #include "header.h"
 #include "dic_exception.h"
 #include "game_io.h"
@@ -238,7 +240,7 @@ wstring parseFileName(const vector<wstring> &tokens, uint8_t index)
     const wstring &wstr = tokens[index];
     BOOST_FOREACH(wchar_t wch, wstr)
     {
-        if (!iswalnum(wch) && wch != L'.' && wch != L'_')
+        if (!iswalnum(wch) && wch != L'.' && wch != L'_' && wch != L'/')
             throw ParsingException("Invalid file name");
     }
     return wstr;
@@ -425,11 +427,23 @@ void help()
     printf("  a8 [] {} : démarrer une partie arbitrage avec\n");
     printf("                [] joueurs humains et {} joueurs IA (partie 7 sur 8)\n");
     printf("  c []     : charger la partie du fichier []\n");
-    printf("  x [] {1} {2} {3} : expressions rationnelles\n");
+    printf("  x [] {1} {2} {3} {4} : expressions rationnelles\n");
     printf("          [] expression à rechercher\n");
     printf("          {1} nombre de résultats à afficher\n");
     printf("          {2} longueur minimum d'un mot\n");
     printf("          {3} longueur maximum d'un mot\n");
+    printf("          {4} nombre de threads (0 pour un par processeur)\n");
+    printf("  xp [] <> {1} {2} {3} : expressions rationnelles, résultats\n");
+    printf("          récupérés par pages de <> mots\n");
+    printf("  xr [] <> {1} {2} {3} : expressions rationnelles, avec les lettres\n");
+    printf("          du tirage <> uniquement ('?' pour un joker)\n");
+    printf("  xc [] {2} {3} : nombre de mots correspondant à l'expression []\n");
+    printf("  xe [] {1} : mots se terminant par les lettres []\n");
+    printf("  w []     : numéro du mot [] dans le dictionnaire\n");
+    printf("  wn []    : mot numéro [] du dictionnaire\n");
+    printf("  wp []    : nombre de mots commençant par []\n");
+    printf("  wf [] {1} : vérifier les mots du fichier [] (un par ligne),\n");
+    printf("             avec {1} threads (0 pour un par processeur)\n");
     printf("  s [b|i] {1} {2} : définir la valeur {2} pour l'option {1},\n");
     printf("                    qui est de type (b)ool ou (i)nt\n");
     printf("  q        : quitter\n");
@@ -540,6 +554,10 @@ void handleRegexp(const Dictionary& iDic, const vector<wstring> &tokens)
     int nres = parseNum(tokens, 2, true, 50);
     int lmin = parseNum(tokens, 3, true, 1);
     int lmax = parseNum(tokens, 4, true, DIC_WORD_MAX - 1);
+    // With a number of threads, also tell whether all the results were
+    // returned, to compare the parallel search with the serial one
+    const bool hasNbThreads = tokens.size() > 5;
+    int nbThreads = parseNum(tokens, 5, true, 1);
 
     if (regexp == L"")
         return;
@@ -554,9 +572,11 @@ void handleRegexp(const Dictionary& iDic, const vector<wstring> &tokens)
            nres, lmin, lmax);
 
     vector<wdstring> wordList;
+    bool complete;
     try
     {
-        iDic.searchRegExp(regexp, wordList, lmin, lmax, nres);
+        complete = iDic.searchRegExp(regexp, wordList, lmin, lmax, nres,
+                                     nbThreads);
     }
     catch (InvalidRegexpException &e)
     {
@@ -569,6 +589,199 @@ void handleRegexp(const Dictionary& iDic, const vector<wstring> &tokens)
         printf("%s\n", lfw(wstr).c_str());
     }
     printf("%u printed results\n", (unsigned)wordList.size());
+    if (hasNbThreads)
+        printf("%s\n", complete ? "all the results" : "more results available");
+}
+
+
+void handleRegexpPages(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    if (tokens.size() < 2)
+        throw ParsingException("Not enough tokens");
+    const wstring &regexp = tokens[1];
+    int pageSize = parseNum(tokens, 2, true, 10);
+    int nres = parseNum(tokens, 3, true, 50);
+    int lmin = parseNum(tokens, 4, true, 1);
+    int lmax = parseNum(tokens, 5, true, DIC_WORD_MAX - 1);
+
+    if (lmax > (DIC_WORD_MAX - 1) || lmin < 1 || lmin > lmax)
+    {
+        printf("bad length -%d,%d-\n", lmin, lmax);
+        return;
+    }
+    if (pageSize < 1)
+    {
+        printf("bad page size -%d-\n", pageSize);
+        return;
+    }
+
+    printf("search for %ls by pages of %d (%d,%d,%d)\n", regexp.c_str(),
+           pageSize, nres, lmin, lmax);
+
+    vector<wdstring> wordList;
+    unsigned int nbPages = 0;
+    try
+    {
+        // Retrieve the words page by page, as a graphical interface would
+        RegexpCursor cursor(iDic, regexp, lmin, lmax);
+        while (!cursor.isFinished() &&
+               (nres == 0 || wordList.size() < (unsigned)nres))
+        {
+            unsigned int nbWords = pageSize;
+            if (nres != 0)
+                nbWords = std::min(nbWords, nres - (unsigned)wordList.size());
+            cursor.getNextWords(wordList, nbWords);
+            ++nbPages;
+        }
+    }
+    catch (InvalidRegexpException &e)
+    {
+        printf("Invalid regular expression: %s\n", e.what());
+        return;
+    }
+
+    BOOST_FOREACH(const wdstring &wstr, wordList)
+    {
+        printf("%s\n", lfw(wstr).c_str());
+    }
+    printf("%u printed results (%u pages)\n", (unsigned)wordList.size(), nbPages);
+}
+
+
+void handleRegexpRack(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    if (tokens.size() < 3)
+        throw ParsingException("Not enough tokens");
+    const wstring &regexp = tokens[1];
+    const wstring &rack = tokens[2];
+    int nres = parseNum(tokens, 3, true, 50);
+    int lmin = parseNum(tokens, 4, true, 1);
+    int lmax = parseNum(tokens, 5, true, DIC_WORD_MAX - 1);
+
+    if (lmax > (DIC_WORD_MAX - 1) || lmin < 1 || lmin > lmax)
+    {
+        printf("bad length -%d,%d-\n", lmin, lmax);
+        return;
+    }
+
+    printf("search for %ls with %ls (%d,%d,%d)\n", regexp.c_str(),
+           rack.c_str(), nres, lmin, lmax);
+
+    vector<wdstring> wordList;
+    try
+    {
+        iDic.searchRegExpRack(regexp, rack, wordList, lmin, lmax, nres);
+    }
+    catch (InvalidRegexpException &e)
+    {
+        printf("Invalid regular expression: %s\n", e.what());
+        return;
+    }
+
+    BOOST_FOREACH(const wdstring &wstr, wordList)
+    {
+        printf("%s\n", lfw(wstr).c_str());
+    }
+    printf("%u printed results\n", (unsigned)wordList.size());
+}
+
+
+void handleRegexpCount(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    if (tokens.size() < 2)
+        throw ParsingException("Not enough tokens");
+    const wstring &regexp = tokens[1];
+    int lmin = parseNum(tokens, 2, true, 1);
+    int lmax = parseNum(tokens, 3, true, DIC_WORD_MAX - 1);
+
+    if (lmax > (DIC_WORD_MAX - 1) || lmin < 1 || lmin > lmax)
+    {
+        printf("bad length -%d,%d-\n", lmin, lmax);
+        return;
+    }
+
+    try
+    {
+        printf("count of %ls (%d,%d): %u\n", regexp.c_str(), lmin, lmax,
+               iDic.countRegExp(regexp, lmin, lmax));
+    }
+    catch (InvalidRegexpException &e)
+    {
+        printf("Invalid regular expression: %s\n", e.what());
+    }
+}
+
+
+void handleEnding(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    const wstring &suffix = parseLetters(tokens, 1, iDic);
+    int nres = parseNum(tokens, 2, true, 50);
+
+    printf("words ending with %ls (%d)\n", suffix.c_str(), nres);
+
+    vector<wdstring> wordList;
+    iDic.searchEnding(suffix, wordList, nres);
+    BOOST_FOREACH(const wdstring &wstr, wordList)
+    {
+        printf("%s\n", lfw(wstr).c_str());
+    }
+    printf("%u printed results\n", (unsigned)wordList.size());
+}
+
+
+void handleWordIds(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    if (tokens[0] == L"wn")
+    {
+        const int id = parseNum(tokens, 1);
+        const wstring &word = iDic.getWordFromId(id);
+        printf("word %d: %ls\n", id, word.c_str());
+    }
+    else if (tokens[0] == L"wp")
+    {
+        const wstring &prefix =
+            tokens.size() > 1 ? parseLetters(tokens, 1, iDic) : L"";
+        printf("words starting with -%ls-: %u\n", prefix.c_str(),
+               iDic.countWordsWithPrefix(toUpper(prefix)));
+    }
+    else
+    {
+        const wstring &word = parseLetters(tokens, 1, iDic);
+        printf("id of -%ls-: %u\n", word.c_str(),
+               iDic.getWordId(toUpper(word)));
+    }
+}
+
+
+void handleWordsFile(const Dictionary& iDic, const vector<wstring> &tokens)
+{
+    const string &fileName = lfw(parseFileName(tokens, 1));
+    int nbThreads = parseNum(tokens, 2, true, 1);
+
+    ifstream file(fileName.c_str());
+    if (!file.is_open())
+    {
+        printf("Cannot open file %s\n", fileName.c_str());
+        return;
+    }
+    vector<wstring> words;
+    string line;
+    while (getline(file, line))
+        words.push_back(convertToWc(line));
+
+    vector<bool> valid;
+    iDic.searchWords(words, valid, nbThreads);
+
+    // Compare with the words checked one by one
+    unsigned int nbValid = 0;
+    for (unsigned int i = 0; i < words.size(); ++i)
+    {
+        if (valid[i])
+            ++nbValid;
+        if (valid[i] != iDic.searchWord(words[i]))
+            printf("mismatch for -%ls- (line %u)\n", words[i].c_str(), i + 1);
+    }
+    printf("%u valid words out of %u\n", nbValid, (unsigned)words.size());
 }
 
 
@@ -985,7 +1198,23 @@ void mainLoop(const Dictionary &iDic)
                     break;
                 case L'x':
                     // Regular expression tests
-                    handleRegexp(iDic, tokens);
+                    if (tokens[0] == L"xr")
+                        handleRegexpRack(iDic, tokens);
+                    else if (tokens[0] == L"xp")
+                        handleRegexpPages(iDic, tokens);
+                    else if (tokens[0] == L"xc")
+                        handleRegexpCount(iDic, tokens);
+                    else if (tokens[0] == L"xe")
+                        handleEnding(iDic, tokens);
+                    else
+                        handleRegexp(iDic, tokens);
+                    break;
+                case L'w':
+                    // Word numbering tests
+                    if (tokens[0] == L"wf")
+                        handleWordsFile(iDic, tokens);
+                    else
+                        handleWordIds(iDic, tokens);
                     break;
                 case L's':
                     setSetting(tokens);